@@ -0,0 +1,78 @@
+#include "radix_sort.hpp"
+#include "benchmark_input.hpp"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+
+// Compares 8, 11 and 16 bit digits for every type with a 16/32/64 bit key.
+// Usage: benchmark_digit_width [elements], 10 million by default.
+
+using namespace std;
+
+template <typename T>
+vector<T> random_input(const unsigned count)
+{
+    mt19937_64 generator(42);
+    vector<T> input(count);
+
+    for (auto& value : input)
+        value = random_value<T>(generator);
+
+    return input;
+}
+
+template <unsigned radix_bits, typename T>
+double time_sort(const vector<T>& input)
+{
+    const unsigned trials = 3;
+
+    double best = 1e100;
+
+    for (unsigned t = 0; t < trials; ++t)
+    {
+        vector<T> data = input;
+        vector<T> temp(data.size());
+
+        auto start = chrono::steady_clock::now();
+
+        radix_sort_lsd_impl<radix_bits>(data.data(), unsigned(data.size()), temp.data(), radix_sort_transform());
+
+        best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    }
+
+    return best;
+}
+
+template <typename T>
+void run_benchmark(const char* type_name, const unsigned count)
+{
+    const vector<T> input = random_input<T>(count);
+
+    const unsigned key_bytes = sizeof(radix_sort_transform()(*input.data()));
+
+    cout << type_name
+         << "\t8 bit: " << time_sort<8>(input) << " sec (" << radix_sort_pass_count<8, key_bytes>::value << " passes)"
+         << "\t11 bit: " << time_sort<11>(input) << " sec (" << radix_sort_pass_count<11, key_bytes>::value << " passes)"
+         << "\t16 bit: " << time_sort<16>(input) << " sec (" << radix_sort_pass_count<16, key_bytes>::value << " passes)"
+         << endl;
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned count = argc > 1 ? unsigned(atoi(argv[1])) : 10000000U;
+
+    cout << "Number of elements: " << count << endl;
+
+    run_benchmark<uint16_t>("uint16_t", count);
+    run_benchmark<int16_t>("int16_t", count);
+    run_benchmark<uint32_t>("uint32_t", count);
+    run_benchmark<int32_t>("int32_t", count);
+    run_benchmark<float>("float", count);
+    run_benchmark<uint64_t>("uint64_t", count);
+    run_benchmark<int64_t>("int64_t", count);
+    run_benchmark<double>("double", count);
+}
@@ -0,0 +1,102 @@
+#include "radix_sort.hpp"
+#include "benchmark_input.hpp"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cstdlib>
+
+// Compares the counting pass with one and with two (split) sets of
+// histograms, for every type on uniform, few unique, sorted and
+// small range input.
+// Usage: benchmark_histogram [elements], 10 million by default.
+
+using namespace std;
+
+template <typename T>
+vector<T> make_input(const unsigned count, const char* distribution)
+{
+    mt19937_64 generator(42);
+    vector<T> input(count);
+
+    T unique[16];
+
+    for (auto& value : unique)
+        value = random_value<T>(generator);
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if (!strcmp(distribution, "uniform"))
+            input[i] = random_value<T>(generator);
+        else if (!strcmp(distribution, "few_unique"))
+            input[i] = unique[generator() % 16];
+        else if (!strcmp(distribution, "small_range"))
+            input[i] = T(generator() % 1000);
+        else
+            input[i] = T(i);
+    }
+
+    return input;
+}
+
+template <bool split, typename T>
+double time_count(const vector<T>& input, vector<unsigned>& histograms)
+{
+    const unsigned trials = 5;
+
+    double best = 1e100;
+
+    for (unsigned t = 0; t < trials; ++t)
+    {
+        fill(histograms.begin(), histograms.end(), 0U);
+
+        auto start = chrono::steady_clock::now();
+
+        radix_sort_count_digits<split, 8>(input.data(), unsigned(input.size()), histograms.data(),
+                                          radix_sort_transform());
+
+        best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    }
+
+    return best;
+}
+
+template <typename T>
+void run_benchmark(const char* type_name, const unsigned count)
+{
+    const char* distributions[] = { "uniform", "few_unique", "sorted", "small_range" };
+
+    for (auto distribution : distributions)
+    {
+        const vector<T> input = make_input<T>(count, distribution);
+
+        vector<unsigned> histograms(sizeof(T) * values_in_byte);
+
+        const double single = time_count<false>(input, histograms);
+        const double split = time_count<true>(input, histograms);
+
+        cout << type_name << "\t" << distribution
+             << "\tsingle: " << single * 1e9 / count << " ns/elem"
+             << "\tsplit: " << split * 1e9 / count << " ns/elem"
+             << "\t(" << single / split << "x)" << endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned count = argc > 1 ? unsigned(atoi(argv[1])) : 10000000U;
+
+    cout << "Number of elements: " << count << endl;
+
+    run_benchmark<uint16_t>("uint16_t", count);
+    run_benchmark<int16_t>("int16_t", count);
+    run_benchmark<uint32_t>("uint32_t", count);
+    run_benchmark<int32_t>("int32_t", count);
+    run_benchmark<float>("float", count);
+    run_benchmark<uint64_t>("uint64_t", count);
+    run_benchmark<int64_t>("int64_t", count);
+    run_benchmark<double>("double", count);
+}
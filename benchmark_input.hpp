@@ -0,0 +1,23 @@
+#include <random>
+#include <cstring>
+#include <cstdint>
+
+#ifndef BENCHMARK_INPUT_H
+#define BENCHMARK_INPUT_H
+
+// Input of the benchmark_* programs: a value of type T made of 64 random bits.
+template <typename T>
+T random_value(std::mt19937_64& generator)
+{
+    uint64_t bits = generator();
+    T value;
+    std::memcpy(&value, &bits, sizeof(T));
+
+    // keep floating point input free of NaN
+    if (value != value)
+        value = T(0);
+
+    return value;
+}
+
+#endif //BENCHMARK_INPUT_H
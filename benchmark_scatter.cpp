@@ -0,0 +1,111 @@
+#include "radix_sort.hpp"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+
+// Compares scatter strategies of a single reordering pass,
+// from L2 resident arrays up to several GB.
+// Usage: benchmark_scatter [max_log2_elements], 27 by default (1 GB of uint64_t).
+
+using namespace std;
+
+template <typename T>
+struct scatter_input
+{
+    vector<T> src;
+    vector<T> dst;
+    unsigned offsets[values_in_byte];
+
+    scatter_input(const unsigned count, mt19937_64& generator) : src(count), dst(count)
+    {
+        for (auto& value : src)
+            value = T(generator());
+
+        unsigned histogram[values_in_byte] = { 0 };
+
+        for (auto value : src)
+            histogram[value & lsb_mask]++;
+
+        unsigned offset = 0;
+
+        for (unsigned value = 0; value < values_in_byte; ++value)
+        {
+            offsets[value] = offset - 1;
+            offset += histogram[value];
+        }
+    }
+};
+
+template <typename T, typename F>
+double time_pass(scatter_input<T>& input, F scatter)
+{
+    const unsigned repeats = max(1U, unsigned((1U << 24) / input.src.size()));
+
+    double best = 1e100;
+
+    for (unsigned r = 0; r < repeats + 1; ++r)
+    {
+        unsigned hist[values_in_byte];
+        copy(input.offsets, input.offsets + values_in_byte, hist);
+
+        auto start = chrono::steady_clock::now();
+
+        scatter(input.src.data(), unsigned(input.src.size()), input.dst.data(), hist);
+
+        best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    }
+
+    return best;
+}
+
+template <typename T>
+void run_benchmark(const char* type_name, const unsigned max_log2_elements)
+{
+    mt19937_64 generator(42);
+
+    auto identity = [](T v) -> T { return v; };
+
+    cout << "Type: " << type_name << endl;
+    cout << "elements\tbytes\tdirect ns/elem\tbuffered ns/elem\tbuffered+nt ns/elem" << endl;
+
+    for (unsigned log2_elements = 12; log2_elements <= max_log2_elements; log2_elements += 3)
+    {
+        const unsigned count = 1U << log2_elements;
+
+        scatter_input<T> input(count, generator);
+
+        const double direct = time_pass(input, [&](T* src, unsigned n, T* dst, unsigned* hist)
+        {
+            radix_sort_scatter_direct(src, n, dst, hist, identity, radix_sort_digit<8>(0));
+        });
+
+        const double buffered = time_pass(input, [&](T* src, unsigned n, T* dst, unsigned* hist)
+        {
+            radix_sort_scatter_buffered<false>(src, n, dst, hist, identity, radix_sort_digit<8>(0));
+        });
+
+        const double non_temporal = time_pass(input, [&](T* src, unsigned n, T* dst, unsigned* hist)
+        {
+            radix_sort_scatter_buffered<true>(src, n, dst, hist, identity, radix_sort_digit<8>(0));
+        });
+
+        cout << count << "\t" << size_t(count) * sizeof(T) << "\t"
+             << direct * 1e9 / count << "\t"
+             << buffered * 1e9 / count << "\t"
+             << non_temporal * 1e9 / count << endl;
+    }
+
+    cout << endl;
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned max_log2_elements = argc > 1 ? unsigned(atoi(argv[1])) : 27;
+
+    run_benchmark<uint32_t>("uint32_t", max_log2_elements);
+    run_benchmark<uint64_t>("uint64_t", max_log2_elements);
+}
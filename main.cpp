@@ -1,40 +1,1253 @@
 #include "radix_sort.hpp"
+#include "radix_sort_external.hpp"
+
+// radix_sort_shared is checked with forked processes on Linux only.
+#ifdef __linux__
+#include "radix_sort_shared.hpp"
+#endif
+
+// The execution policy front end is only checked on request, as the
+// parallel std::sort needs -ltbb with libstdc++.
+#ifdef RADIX_SORT_CHECK_EXECUTION
+#include "radix_sort_execution.hpp"
+#endif
 
 #include <iostream>
+#include <sstream>
 #include <vector>
 #include <algorithm>
-#include <ctime>
+#include <chrono>
 #include <string>
 #include <cassert>
 #include <random>
 #include <type_traits>
+#include <limits>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <array>
+#include <tuple>
+#include <cstdio>
+#include <thread>
+
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/*
+    Benchmark of radix_sort against std::sort and std::stable_sort.
+
+    Every combination of type, distribution and size is sorted by every
+    algorithm: warm-up runs first, then repeated trials of wall time.
+    The result is printed to stdout as JSON: median and p99 time per sort
+    and elements per second, and with --counters hardware counters
+    (cache and TLB misses) of one more run, for radix_sort also of every
+    phase and reordering pass of one sort. Progress goes to stderr.
+    The radix_sort result is checked against std::sort after warm-up.
+    Inputs of up to check_max_elements also go through checks of the other
+    entry points against the standard algorithms, before the benchmark.
+    Built with -DRADIX_SORT_CHECK_EXECUTION (and -ltbb with libstdc++), the
+    checks cover the execution policy front end as well.
+
+    Usage: main [options]
+      --min-elements N    smallest size, 16 by default
+      --max-bytes N       largest size in bytes, 256 MB by default;
+                          accepts K, M and G suffixes, e.g. 4G
+      --trials N          timed trials per measurement, 11 by default;
+                          fewer (not less than 3) if they take over 10 sec
+      --warmup N          untimed runs before the trials, 1 by default
+      --types LIST        comma separated, e.g. uint32_t,double; all by default
+      --distributions LIST  comma separated, all by default
+      --algorithms LIST   radix_sort, std::sort, std::stable_sort; all by default
+      --counters          read perf_event_open counters (Linux)
+      --check-only        run the checks only, on sizes up to
+                          check_max_elements, and print no results
+      --seed N            seed of the input generator, 42 by default
+
+    Sizes grow 8 times per step. Sorts of small arrays are timed in batches
+    of separate copies, so that every timed interval is long enough for the
+    clock; the reported time is per sort.
+*/
+
+using namespace std;
+
+// Order radix_sort is expected to produce.
+// For floating point types: -0.0 goes before +0.0 and NaN goes last.
+struct expected_less
+{
+    template <typename T>
+    bool operator()(T a, T b) const
+    {
+        if (!is_floating_point<T>::value)
+            return a < b;
+
+        if (std::isnan(a) || std::isnan(b))
+            return !std::isnan(a);
+
+        return a < b || (a == b && std::signbit(a) && !std::signbit(b));
+    }
+};
+
+template <typename T>
+bool sorted_and_equal(const vector<T> & sorted, vector<T> original)
+{
+    assert(sorted.size() == original.size());
+
+    std::sort(original.begin(), original.end(), expected_less());
+
+    // Bitwise comparison, so that NaN == NaN and -0.0 != +0.0
+    for(unsigned i = 0; i < sorted.size(); ++i)
+        if (memcmp(&sorted[i], &original[i], sizeof(T)) != 0)
+            return false;
+
+    return true;
+}
+
+// radix_sort of 8 bit types needs no buffer.
+template <typename T>
+void radix_sort_ordered(T* values, unsigned count, T* temp, radix_sort_order order)
+{
+    radix_sort(values, count, temp, order);
+}
+
+void radix_sort_ordered(uint8_t* values, unsigned count, uint8_t*, radix_sort_order order)
+{
+    radix_sort(values, count, order);
+}
+
+void radix_sort_ordered(int8_t* values, unsigned count, int8_t*, radix_sort_order order)
+{
+    radix_sort(values, count, order);
+}
+
+// Expected result of a stable sort in the given order.
+template <typename T>
+vector<T> stable_sorted(vector<T> values, radix_sort_order order = radix_sort_order::ascending)
+{
+    if (order == radix_sort_order::descending)
+        std::stable_sort(values.begin(), values.end(), [](T a, T b) { return expected_less()(b, a); });
+    else
+        std::stable_sort(values.begin(), values.end(), expected_less());
+
+    return values;
+}
+
+// Bitwise comparison, so that NaN == NaN and -0.0 != +0.0
+template <typename T>
+bool bitwise_equal(const vector<T> & a, const vector<T> & b)
+{
+    return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+// Positions of the elements of input in the order of a stable sort.
+template <typename T>
+vector<unsigned> stable_positions(const vector<T> & input, radix_sort_order order)
+{
+    vector<unsigned> positions(input.size());
+
+    for (unsigned i = 0; i < positions.size(); ++i)
+        positions[i] = i;
+
+    std::stable_sort(positions.begin(), positions.end(), [&](unsigned a, unsigned b)
+    {
+        return order == radix_sort_order::descending ? expected_less()(input[b], input[a])
+                                                     : expected_less()(input[a], input[b]);
+    });
+
+    return positions;
+}
+
+// Keys that are input[positions[0]], input[positions[1]], ..
+template <typename T>
+bool keys_at_positions(const T* keys, const vector<T> & input, const vector<unsigned> & positions)
+{
+    for (unsigned i = 0; i < positions.size(); ++i)
+        if (memcmp(&keys[i], &input[positions[i]], sizeof(T)) != 0)
+            return false;
+
+    return true;
+}
+
+const radix_sort_order orders[] = { radix_sort_order::ascending, radix_sort_order::descending };
+
+const unsigned check_max_elements = 1U << 20;
+
+// radix_sort in descending order, the ascending one is checked by the benchmark.
+template <typename T>
+bool check_descending(const vector<T> & input)
+{
+    vector<T> values = input;
+    vector<T> temp(input.size());
+
+    radix_sort_ordered(values.data(), unsigned(values.size()), temp.data(), radix_sort_order::descending);
+
+    return bitwise_equal(values, stable_sorted(input, radix_sort_order::descending));
+}
+
+// 8 bit types have no parallel, shared, payload, merge and file versions.
+template <typename T>
+bool check_parallel(const vector<T> & input, true_type)
+{
+    for (auto order : orders)
+    {
+        for (unsigned threads : { 1U, 4U })
+        {
+            vector<T> values = input;
+            vector<T> temp(input.size());
+
+            radix_sort_parallel(values.data(), unsigned(values.size()), temp.data(), threads, order);
+
+            if (!bitwise_equal(values, stable_sorted(input, order)))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename T>
+bool check_parallel(const vector<T> &, false_type)
+{
+    return true;
+}
+
+#ifdef __linux__
+// Three forked processes sort together in anonymous shared mappings, the
+// control block serves the sorts of both orders.
+template <typename T>
+bool check_shared(const vector<T> & input, true_type)
+{
+    const unsigned process_count = 3;
+    const unsigned count = unsigned(input.size());
+
+    if (!count)
+        return true;
+
+    const size_t control_size = radix_sort_shared_control_size(process_count);
+    const size_t values_size = 2 * size_t(count) * sizeof(T);
+
+    void* control_memory = mmap(nullptr, control_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    void* values_memory = mmap(nullptr, values_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    bool ok = control_memory != MAP_FAILED && values_memory != MAP_FAILED;
+
+    radix_sort_shared_control* control = ok ? radix_sort_shared_init(control_memory, process_count) : nullptr;
+
+    T* values = static_cast<T*>(values_memory);
+
+    for (unsigned o = 0; control && ok && o < sizeof(orders) / sizeof(orders[0]); ++o)
+    {
+        copy(input.begin(), input.end(), values);
+
+        for (unsigned rank = 0; rank < process_count; ++rank)
+        {
+            if (fork() == 0)
+            {
+                radix_sort_shared(values, count, values + count, control, rank, orders[o]);
+                _exit(0);
+            }
+        }
+
+        int status;
+
+        for (unsigned rank = 0; rank < process_count; ++rank)
+            if (wait(&status) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                ok = false;
+
+        ok = ok && bitwise_equal(vector<T>(values, values + count), stable_sorted(input, orders[o]));
+    }
+
+    if (control)
+        radix_sort_shared_destroy(control);
+    else
+        ok = false;
+
+    if (control_memory != MAP_FAILED)
+        munmap(control_memory, control_size);
+
+    if (values_memory != MAP_FAILED)
+        munmap(values_memory, values_size);
+
+    return ok;
+}
+#endif
+
+// 8 bit types, and every type without Linux.
+template <typename T, typename Wide>
+bool check_shared(const vector<T> &, Wide)
+{
+    return true;
+}
+
+// Two payload columns: the position of every key and its complement,
+// which also shows that equal keys keep their order.
+template <typename T>
+bool check_payload(const vector<T> & input, true_type)
+{
+    const unsigned count = unsigned(input.size());
+
+    for (auto order : orders)
+    {
+        vector<T> keys = input;
+        vector<T> keys_temp(count);
+        vector<unsigned> positions(count), positions_temp(count);
+        vector<uint64_t> complements(count), complements_temp(count);
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            positions[i] = i;
+            complements[i] = ~uint64_t(i);
+        }
+
+        radix_sort_with_payload(keys.data(), count, keys_temp.data(), order,
+                                radix_sort_make_payload(positions.data(), positions_temp.data()),
+                                radix_sort_make_payload(complements.data(), complements_temp.data()));
+
+        const vector<unsigned> expected = stable_positions(input, order);
+
+        if (positions != expected || !keys_at_positions(keys.data(), input, expected))
+            return false;
+
+        for (unsigned i = 0; i < count; ++i)
+            if (complements[i] != ~uint64_t(expected[i]))
+                return false;
+    }
+
+    return true;
+}
+
+template <typename T>
+bool check_payload(const vector<T> &, false_type)
+{
+    return true;
+}
+
+// Not stable, but equal keys are equal bitwise.
+template <typename T>
+bool check_in_place(const vector<T> & input)
+{
+    for (auto order : orders)
+    {
+        vector<T> values = input;
+
+        radix_sort_in_place(values.data(), unsigned(values.size()), order);
+
+        if (!bitwise_equal(values, stable_sorted(input, order)))
+            return false;
+    }
+
+    return true;
+}
+
+// The first half of input sorted, then merged with a small batch (which
+// gallops), two of an eighth of the input and the rest, with each of the
+// in-place and the dst versions, with a buffer and with a workspace.
+template <typename T>
+bool check_merge_batch(const vector<T> & input, true_type)
+{
+    const size_t count = input.size();
+    const size_t ends[] = { count / 2, count / 2 + count / 64 + 1, count / 2 + count / 64 + count / 8 + 1,
+                            count / 2 + count / 64 + count / 4 + 1, count };
+
+    radix_sort_workspace workspace;
+
+    for (auto order : orders)
+    {
+        vector<T> sorted = stable_sorted(vector<T>(input.begin(), input.begin() + ends[0]), order);
+
+        for (unsigned step = 1; step < 5 && ends[step - 1] < count; ++step)
+        {
+            const size_t sorted_count = sorted.size();
+            const size_t end = min(ends[step], count);
+
+            vector<T> batch(input.begin() + ends[step - 1], input.begin() + end);
+            vector<T> temp(batch.size());
+            vector<T> dst(sorted_count + batch.size());
+
+            const unsigned batch_count = unsigned(batch.size());
+            const T* unchanged = sorted.data();
+
+            switch (step)
+            {
+                case 1:
+                    sorted.resize(sorted_count + batch_count);
+                    radix_sort_merge_batch(sorted.data(), sorted_count, batch.data(), batch_count, temp.data(), order);
+                    break;
+                case 2:
+                    sorted.resize(sorted_count + batch_count);
+                    radix_sort_merge_batch(sorted.data(), sorted_count, batch.data(), batch_count, workspace, order);
+                    break;
+                case 3:
+                    radix_sort_merge_batch(unchanged, sorted_count, batch.data(), batch_count, temp.data(),
+                                           dst.data(), order);
+                    sorted.swap(dst);
+                    break;
+                default:
+                    radix_sort_merge_batch(unchanged, sorted_count, batch.data(), batch_count, workspace,
+                                           dst.data(), order);
+                    sorted.swap(dst);
+            }
+
+            if (!bitwise_equal(sorted, stable_sorted(vector<T>(input.begin(), input.begin() + end), order)))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename T>
+bool check_merge_batch(const vector<T> &, false_type)
+{
+    return true;
+}
+
+// radix_sort_unique and radix_sort_counts against std::unique of the sorted
+// input and the lengths of its runs, with and without a buffer.
+template <typename T>
+bool check_unique(const vector<T> & input)
+{
+    const unsigned count = unsigned(input.size());
+
+    for (auto order : orders)
+    {
+        vector<T> expected = stable_sorted(input, order);
+        vector<unsigned> expected_counts;
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            if (i && !memcmp(&expected[i], &expected[i - 1], sizeof(T)))
+                expected_counts.back()++;
+            else
+                expected_counts.push_back(1);
+        }
+
+        expected.erase(std::unique(expected.begin(), expected.end(), [](T a, T b)
+        {
+            return memcmp(&a, &b, sizeof(T)) == 0;
+        }), expected.end());
+
+        for (bool buffer : { false, true })
+        {
+            vector<T> values = input;
+            vector<T> temp(count);
+            vector<unsigned> counts(count);
+
+            values.resize(buffer ? radix_sort_unique(values.data(), count, temp.data(), order)
+                                 : radix_sort_unique(values.data(), count, order));
+
+            if (!bitwise_equal(values, expected))
+                return false;
+
+            values = input;
+
+            const unsigned distinct = buffer
+                ? radix_sort_counts(values.data(), count, temp.data(), counts.data(), order)
+                : radix_sort_counts(values.data(), count, counts.data(), order);
+
+            values.resize(distinct);
+            counts.resize(distinct);
+
+            if (!bitwise_equal(values, expected) || counts != expected_counts)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// Files of the file sort checks go to $TMPDIR, or /tmp. Their names end in
+// a number picked once per process, so that the checks of several builds
+// can run at the same time.
+string check_path(const char* name)
+{
+    static const string suffix = "." + to_string(random_device()());
+
+    const char* dir = getenv("TMPDIR");
+
+    return string(dir && *dir ? dir : "/tmp") + "/" + name + (*name ? suffix : "");
+}
+
+template <typename T>
+bool write_values(const string & path, const vector<T> & values)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+
+    if (!file)
+        return false;
+
+    const bool written = fwrite(values.data(), sizeof(T), values.size(), file) == values.size();
+
+    return fclose(file) == 0 && written;
+}
+
+template <typename T>
+vector<T> read_values(const string & path, const size_t count)
+{
+    vector<T> values(count);
+
+    FILE* file = fopen(path.c_str(), "rb");
+
+    if (!file)
+        return vector<T>();
+
+    values.resize(fread(values.data(), sizeof(T), count, file));
+    fclose(file);
+
+    return values;
+}
+
+// Sorts values with radix_sort and a buffer in both orders and compares
+// them with std::sort by less, as equivalent under less (NaN != NaN).
+template <typename K, typename Less>
+bool check_composite(const vector<K> & values, Less less)
+{
+    for (auto order : orders)
+    {
+        vector<K> expected = values;
+
+        if (order == radix_sort_order::descending)
+            std::sort(expected.begin(), expected.end(), [&](const K & a, const K & b) { return less(b, a); });
+        else
+            std::sort(expected.begin(), expected.end(), less);
+
+        vector<K> sorted = values;
+        vector<K> temp(values.size());
+
+        radix_sort(sorted.data(), unsigned(sorted.size()), temp.data(), order);
+
+        for (size_t i = 0; i < values.size(); ++i)
+            if (less(sorted[i], expected[i]) || less(expected[i], sorted[i]))
+                return false;
+
+        // radix_sort_file, with about 4 runs merged in the same order.
+        const string input_path = check_path("radix_sort_check_composite_input");
+        const string output_path = check_path("radix_sort_check_composite_output");
+
+        const size_t memory_budget = 3 * sizeof(K) * max(size_t(1), values.size() / 4);
+
+        bool ok = write_values(input_path, values) &&
+                  radix_sort_file<K>(input_path.c_str(), output_path.c_str(), memory_budget, nullptr, order);
+
+        sorted = read_values<K>(output_path, values.size());
+
+        remove(input_path.c_str());
+        remove(output_path.c_str());
+
+        if (!ok || sorted.size() != values.size())
+            return false;
+
+        for (size_t i = 0; i < values.size(); ++i)
+            if (less(sorted[i], expected[i]) || less(expected[i], sorted[i]))
+                return false;
+    }
+
+    return true;
+}
+
+#ifdef __SIZEOF_INT128__
+// Values in the high half, positions in the low one. Built unsigned, as
+// the signed shift of a value of 2^63 and more would overflow.
+template <typename T>
+bool check_int128(const vector<T> & input, true_type)
+{
+    vector<__int128> values(input.size());
+    vector<unsigned __int128> unsigned_values(input.size());
+
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        values[i] = __int128((unsigned __int128)(input[i]) << 64 | i);
+        unsigned_values[i] = (unsigned __int128)(values[i]) * 3;
+    }
+
+    return check_composite(values, less<__int128>()) &&
+           check_composite(unsigned_values, less<unsigned __int128>());
+}
+#endif
+
+template <typename T>
+bool check_int128(const vector<T> &, false_type)
+{
+    return true;
+}
+
+// Pairs and tuples of a value with narrower components, compared in the
+// order radix_sort gives T; byte arrays of the bytes of every value.
+template <typename T>
+bool check_composite_keys(const vector<T> & input)
+{
+    const size_t count = input.size();
+
+    vector<pair<T, uint32_t>> pairs(count);
+    vector<tuple<uint8_t, T, int16_t>> tuples(count);
+    vector<array<unsigned char, 12>> arrays(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        unsigned char bytes[sizeof(T)];
+        memcpy(bytes, &input[i], sizeof(T));
+
+        pairs[i] = make_pair(input[i], uint32_t(i % 3));
+        tuples[i] = make_tuple(uint8_t(bytes[0] % 4), input[i], int16_t(int(i % 5) - 2));
+
+        arrays[i].fill(0);
+        copy(bytes, bytes + sizeof(T), arrays[i].begin() + (i % 2));
+        arrays[i][11] = (unsigned char)(i);
+    }
+
+    auto less_value = [](T a, T b) { return expected_less()(a, b); };
+
+    auto pair_less = [&](const pair<T, uint32_t> & a, const pair<T, uint32_t> & b)
+    {
+        return less_value(a.first, b.first) || (!less_value(b.first, a.first) && a.second < b.second);
+    };
+
+    auto tuple_less = [&](const tuple<uint8_t, T, int16_t> & a, const tuple<uint8_t, T, int16_t> & b)
+    {
+        if (get<0>(a) != get<0>(b))
+            return get<0>(a) < get<0>(b);
+
+        if (less_value(get<1>(a), get<1>(b)) || less_value(get<1>(b), get<1>(a)))
+            return less_value(get<1>(a), get<1>(b));
+
+        return get<2>(a) < get<2>(b);
+    };
+
+    return check_composite(pairs, pair_less) && check_composite(tuples, tuple_less) &&
+           check_composite(arrays, less<array<unsigned char, 12>>()) &&
+           check_int128(input, integral_constant<bool, is_integral<T>::value>());
+}
+
+// Both orders at once with runs in the same directory, the input split
+// into about 4 runs. A file that ends in the middle of a value is refused.
+template <typename T>
+bool check_file(const vector<T> & input, true_type)
+{
+    const string dir = check_path("");
+    const string input_path = check_path("radix_sort_check_input");
+    const string output_paths[] = { check_path("radix_sort_check_ascending"),
+                                    check_path("radix_sort_check_descending") };
+
+    const size_t memory_budget = 3 * sizeof(T) * max(size_t(1), input.size() / 4);
+
+    bool ok = write_values(input_path, input);
+    bool sorted[2] = { false, false };
+
+    thread other([&]
+    {
+        sorted[1] = radix_sort_file<T>(input_path.c_str(), output_paths[1].c_str(), memory_budget, dir.c_str(),
+                                       radix_sort_order::descending);
+    });
+
+    sorted[0] = radix_sort_file<T>(input_path.c_str(), output_paths[0].c_str(), memory_budget, dir.c_str(),
+                                   radix_sort_order::ascending);
+
+    other.join();
+
+    for (unsigned o = 0; o < 2; ++o)
+        ok = ok && sorted[o] && bitwise_equal(read_values<T>(output_paths[o], input.size()),
+                                              stable_sorted(input, orders[o]));
+
+    FILE* file = fopen(input_path.c_str(), "ab");
+
+    ok = ok && file && fputc(0, file) != EOF;
+
+    if (file)
+        fclose(file);
+
+    ok = ok && !radix_sort_file<T>(input_path.c_str(), output_paths[0].c_str(), memory_budget, dir.c_str());
+
+    remove(input_path.c_str());
+    remove(output_paths[0].c_str());
+    remove(output_paths[1].c_str());
+
+    return ok;
+}
+
+template <typename T>
+bool check_file(const vector<T> &, false_type)
+{
+    return true;
+}
+
+// String keys made of the bytes of every value, from the most significant
+// one on little endian machines, 0 .. sizeof(T) of them depending on the
+// lowest one, so many keys are prefixes of others.
+template <typename T>
+bool check_strings(const vector<T> & input)
+{
+    vector<string> strings(input.size());
+
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        unsigned char bytes[sizeof(T)];
+        memcpy(bytes, &input[i], sizeof(T));
+
+        reverse(bytes, bytes + sizeof(T));
+        strings[i].assign(reinterpret_cast<char*>(bytes), bytes[sizeof(T) - 1] % (sizeof(T) + 1));
+    }
+
+    for (auto order : orders)
+    {
+        vector<string> expected = strings;
+
+        if (order == radix_sort_order::descending)
+            std::sort(expected.begin(), expected.end(), greater<string>());
+        else
+            std::sort(expected.begin(), expected.end());
+
+        vector<string> values = strings;
+        radix_sort(values.data(), unsigned(values.size()), order);
+
+        if (values != expected)
+            return false;
+
+        vector<radix_sort_byte_key> keys(strings.size());
+
+        for (size_t i = 0; i < keys.size(); ++i)
+            keys[i] = radix_sort_byte_key{ strings[i].data(), strings[i].size() };
+
+        radix_sort(keys.data(), unsigned(keys.size()), order);
+
+        for (size_t i = 0; i < keys.size(); ++i)
+            if (string(keys[i].data, keys[i].length) != expected[i])
+                return false;
+    }
+
+    return true;
+}
+
+// Segments of random sizes around 10, 100 and 1000 elements, so that every
+// kernel gets some; with a workspace and with 1 and 4 threads.
+template <typename T>
+bool check_segmented(const vector<T> & input)
+{
+    const unsigned count = unsigned(input.size());
+
+    mt19937_64 generator(count);
+
+    for (unsigned average_size : { 10U, 100U, 1000U })
+    {
+        vector<unsigned> offsets(1, 0);
+
+        uniform_int_distribution<unsigned> segment_size(0, 2 * average_size);
+
+        while (offsets.back() < count)
+            offsets.push_back(min(count, offsets.back() + segment_size(generator)));
+
+        const unsigned segments = unsigned(offsets.size() - 1);
+
+        for (auto order : orders)
+        {
+            vector<T> expected = input;
+
+            for (unsigned segment = 0; segment < segments; ++segment)
+            {
+                const vector<T> part = stable_sorted(vector<T>(input.begin() + offsets[segment],
+                                                               input.begin() + offsets[segment + 1]), order);
+
+                copy(part.begin(), part.end(), expected.begin() + offsets[segment]);
+            }
+
+            radix_sort_workspace workspace;
+
+            vector<T> values = input;
+            radix_sort_segmented(values.data(), offsets.data(), segments, workspace, order);
+
+            if (!bitwise_equal(values, expected))
+                return false;
+
+            for (unsigned threads : { 1U, 4U })
+            {
+                values = input;
+                radix_sort_segmented(values.data(), offsets.data(), segments, threads, order);
+
+                if (!bitwise_equal(values, expected))
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+template <typename T>
+struct check_record
+{
+    T key;
+    unsigned position;
+};
+
+template <typename T>
+struct check_named_record
+{
+    T key;
+    string name;
+};
+
+// Records with their position in the input, with a buffer and with a
+// workspace, so equal keys must keep their order. Records that aren't
+// trivially copyable only have the buffer version.
+template <typename T>
+bool check_by_key(const vector<T> & input)
+{
+    const unsigned count = unsigned(input.size());
+
+    radix_sort_workspace workspace;
+
+    for (auto order : orders)
+    {
+        const vector<unsigned> expected = stable_positions(input, order);
+
+        for (bool with_workspace : { false, true })
+        {
+            vector<check_record<T>> records(count), temp(count);
+
+            for (unsigned i = 0; i < count; ++i)
+                records[i] = check_record<T>{ input[i], i };
+
+            auto key = [](const check_record<T> & record) { return record.key; };
+
+            if (with_workspace)
+                radix_sort_by_key(records.data(), count, key, workspace, order);
+            else
+                radix_sort_by_key(records.data(), count, key, temp.data(), order);
+
+            for (unsigned i = 0; i < count; ++i)
+                if (records[i].position != expected[i])
+                    return false;
+        }
+
+        vector<check_named_record<T>> named(count), named_temp(count);
+
+        for (unsigned i = 0; i < count; ++i)
+            named[i] = check_named_record<T>{ input[i], to_string(i) };
+
+        radix_sort_by_key(named.data(), count, [](const check_named_record<T> & record) { return record.key; },
+                          named_temp.data(), order);
+
+        for (unsigned i = 0; i < count; ++i)
+            if (named[i].name != to_string(expected[i]))
+                return false;
+    }
+
+    return true;
+}
+
+struct check_record_key
+{
+    template <typename T>
+    T operator()(const check_record<T> & record) const
+    {
+        return record.key;
+    }
+};
+
+// Feeds the builder chunks of growing size, appended and written in place
+// in turns (with more room prepared than committed), twice with a clear in
+// between; records with their position show that it's stable.
+template <typename B, typename T, typename Make>
+bool check_builder_feed(B & builder, const vector<T> & input, Make make)
+{
+    unsigned chunk = 1;
+    bool in_place = false;
+
+    for (unsigned begin = 0; begin < input.size(); begin += chunk, chunk = chunk * 2 + 1, in_place = !in_place)
+    {
+        const unsigned size = min(chunk, unsigned(input.size()) - begin);
+
+        if (in_place)
+        {
+            auto room = builder.prepare(size + 3);
+
+            for (unsigned i = 0; i < size; ++i)
+                room[i] = make(begin + i);
+
+            builder.commit(size);
+        }
+        else
+        {
+            vector<decltype(make(0U))> elements;
+
+            for (unsigned i = 0; i < size; ++i)
+                elements.push_back(make(begin + i));
+
+            builder.append(elements.data(), size);
+        }
+    }
+
+    builder.finish();
+
+    return builder.size() == input.size();
+}
+
+template <typename T>
+vector<T> builder_values(radix_sort_builder<T> & builder)
+{
+    return vector<T>(builder.data(), builder.data() + builder.size());
+}
+
+template <typename T>
+bool check_builder(const vector<T> & input)
+{
+    for (auto order : orders)
+    {
+        const vector<T> expected = stable_sorted(input, order);
+        const vector<unsigned> positions = stable_positions(input, order);
+
+        radix_sort_builder<T> builder(order);
+        radix_sort_builder<check_record<T>, radix_sort_key_transform<check_record_key>> records(
+            order, radix_sort_key_transform<check_record_key>(check_record_key()));
+
+        for (unsigned round = 0; round < 2; ++round)
+        {
+            builder.clear();
+            records.clear();
+
+            if (!check_builder_feed(builder, input, [&](unsigned i) { return input[i]; }) ||
+                !bitwise_equal(builder_values(builder), expected))
+                return false;
+
+            if (!check_builder_feed(records, input, [&](unsigned i) { return check_record<T>{ input[i], i }; }))
+                return false;
+
+            for (unsigned i = 0; i < records.size(); ++i)
+                if (records.data()[i].position != positions[i])
+                    return false;
+        }
+
+        // finish() again leaves the result as it is, a chunk appended after
+        // it is sorted together with the result by the next finish().
+        builder.finish();
+        records.finish();
+
+        if (!bitwise_equal(builder_values(builder), expected))
+            return false;
+
+        for (unsigned i = 0; i < records.size(); ++i)
+            if (records.data()[i].position != positions[i])
+                return false;
+
+        const unsigned count = unsigned(input.size());
+
+        vector<T> twice = input;
+        twice.insert(twice.end(), input.begin(), input.end());
+
+        vector<check_record<T>> again;
+
+        for (unsigned i = 0; i < count; ++i)
+            again.push_back(check_record<T>{ input[i], count + i });
+
+        builder.append(input.data(), count);
+        records.append(again.data(), count);
+        builder.finish();
+        records.finish();
+
+        const vector<unsigned> twice_positions = stable_positions(twice, order);
+
+        if (!bitwise_equal(builder_values(builder), stable_sorted(twice, order)) ||
+            records.size() != twice.size())
+            return false;
+
+        for (unsigned i = 0; i < records.size(); ++i)
+            if (records.data()[i].position != twice_positions[i])
+                return false;
+    }
+
+    return true;
+}
+
+// radix_nth_element against std::nth_element, radix_top_k and
+// radix_partial_sort against the sorted order, for k at both ends and in
+// the middle.
+template <typename T>
+bool check_select(const vector<T> & input)
+{
+    const unsigned count = unsigned(input.size());
+
+    for (auto order : orders)
+    {
+        const vector<T> expected = stable_sorted(input, order);
+
+        auto before = [&](T a, T b)
+        {
+            return order == radix_sort_order::descending ? expected_less()(b, a) : expected_less()(a, b);
+        };
+
+        for (unsigned k : { 0U, count / 2, count - 1 })
+        {
+            vector<T> nth = input;
+            std::nth_element(nth.begin(), nth.begin() + k, nth.end(), before);
+
+            vector<T> values = input;
+            radix_nth_element(values.data(), count, k, order);
+
+            if (memcmp(&values[k], &nth[k], sizeof(T)) != 0)
+                return false;
+
+            for (unsigned i = 0; i < count; ++i)
+                if (i < k ? before(values[k], values[i]) : before(values[i], values[k]))
+                    return false;
+
+            values = input;
+            radix_top_k(values.data(), count, k, order);
+
+            std::stable_sort(values.begin(), values.begin() + k, before);
+
+            if (memcmp(values.data(), expected.data(), k * sizeof(T)) != 0)
+                return false;
+
+            values = input;
+            radix_partial_sort(values.data(), count, k, order);
+
+            if (memcmp(values.data(), expected.data(), k * sizeof(T)) != 0)
+                return false;
+
+            if (!bitwise_equal(stable_sorted(values, order), expected))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// Keys that are all prefixes of one another ("a", "aa", "aaa", ..) must not
+// make the recursion of the string sort as deep. Runs once, not per input.
+bool check_nested_prefixes()
+{
+    const unsigned count = 20000;
+    const string nested(count, 'a');
+
+    vector<radix_sort_byte_key> keys(count);
+
+    for (auto order : orders)
+    {
+        for (unsigned i = 0; i < count; ++i)
+            keys[i] = radix_sort_byte_key{ nested.data(), size_t(i % 2 ? i : count - i) };
+
+        radix_sort(keys.data(), count, order);
+
+        for (unsigned i = 0; i < count; ++i)
+            if (keys[i].length != (order == radix_sort_order::descending ? count - i : i + 1))
+                return false;
+    }
+
+    return true;
+}
+
+// radix_sort_stats of a sort of 32 bit keys whose high byte is the same in
+// all of them: the passes of the digits within that byte are reported as
+// skipped and move nothing, every other pass moves count * sizeof(key)
+// bytes, and so does the copy back after an odd number of them. Sorted
+// input is left after the counting pass, with no pass reported.
+// Runs once, not per input.
+bool check_stats()
+{
+    const unsigned count = 10000;
+    const unsigned radix_bits = RADIX_SORT_DIGIT_BITS;
+    const unsigned passes = radix_sort_pass_count<radix_bits, sizeof(uint32_t)>::value;
+
+    vector<uint32_t> values(count), temp(count);
+
+    for (unsigned i = 0; i < count; ++i)
+        values[i] = 0x5A000000U | ((i * 2654435761U) >> 8);
+
+    radix_sort_stats stats;
+    radix_sort_32_impl(values.data(), count, temp.data(), radix_sort_transform(), stats);
+
+    if (stats.passes.size() != passes || !is_sorted(values.begin(), values.end()))
+        return false;
+
+    unsigned scatter_passes = 0;
+    size_t scatter_bytes = 0;
+
+    for (unsigned pass = 0; pass < passes; ++pass)
+    {
+        const radix_sort_pass_stats & pass_stats = stats.passes[pass];
+        const bool in_high_byte = pass * radix_bits >= 24;
+
+        if (pass_stats.pass != pass || pass_stats.skipped != in_high_byte)
+            return false;
+
+        if (in_high_byte && (pass_stats.bytes_moved != 0 || pass_stats.non_empty_buckets != 1 ||
+                             pass_stats.max_bucket_size != count))
+            return false;
+
+        if (!in_high_byte && pass_stats.bytes_moved != count * sizeof(uint32_t))
+            return false;
+
+        scatter_passes += !pass_stats.skipped;
+        scatter_bytes += pass_stats.bytes_moved;
+    }
+
+    const size_t copy_back_bytes = scatter_passes % 2 ? count * sizeof(uint32_t) : 0;
+
+    if (stats.bytes_moved != scatter_bytes + copy_back_bytes)
+        return false;
+
+    radix_sort_stats sorted_stats;
+    radix_sort_32_impl(values.data(), count, temp.data(), radix_sort_transform(), sorted_stats);
 
-using namespace std;
+    return sorted_stats.passes.empty() && sorted_stats.bytes_moved == 0;
+}
 
-template <typename T>
-void call_radix_sort(vector<T> & main)
+template <typename V, typename Sort>
+bool sorts_to(const vector<V> & values, const vector<V> & expected, Sort sort)
+{
+    vector<V> sorted = values;
+    sort(sorted);
+
+    return bitwise_equal(sorted, expected);
+}
+
+// Iterators, containers, std::span, the parallel versions and execution
+// policies, against std::stable_sort.
+template <typename V>
+bool check_front_end_values(const vector<V> & values)
+{
+    for (auto order : orders)
+    {
+        const vector<V> expected = stable_sorted(values, order);
+
+        bool ok = sorts_to(values, expected, [&](vector<V> & v) { radix_sort(v.begin(), v.end(), order); }) &&
+                  sorts_to(values, expected, [&](vector<V> & v) { radix_sort(v, order); }) &&
+                  sorts_to(values, expected, [&](vector<V> & v)
+                  {
+                      radix_sort(v.data(), v.data() + v.size(), order);
+                  }) &&
+                  sorts_to(values, expected, [&](vector<V> & v) { radix_sort_parallel(v.begin(), v.end(), order); }) &&
+                  sorts_to(values, expected, [&](vector<V> & v) { radix_sort_parallel(v, order); });
+
+#if __cplusplus >= 202002L
+        ok = ok && sorts_to(values, expected, [&](vector<V> & v) { radix_sort(span<V>(v), order); });
+#endif
+
+#ifdef RADIX_SORT_CHECK_EXECUTION
+        ok = ok && sorts_to(values, expected, [&](vector<V> & v) { radix_sort(execution::seq, v, order); }) &&
+                   sorts_to(values, expected, [&](vector<V> & v) { radix_sort(execution::par, v, order); }) &&
+                   sorts_to(values, expected, [&](vector<V> & v)
+                   {
+                       radix_sort(execution::par_unseq, v.begin(), v.end(), order);
+                   });
+#endif
+
+        if (!ok)
+            return false;
+    }
+
+    return true;
+}
+
+// The bits of every value, from the most significant one, as an integer of
+// type I; long long, long and char are not all fixed width types.
+template <typename I, typename T>
+vector<I> bits_as(const vector<T> & input)
 {
-    radix_sort(main.data(), main.size());
+    vector<I> values(input.size());
+
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        uint64_t bits = 0;
+        memcpy(&bits, &input[i], sizeof(T));
+
+        values[i] = I(bits << (64 - 8 * sizeof(T)) >> (64 - 8 * sizeof(I)));
+    }
+
+    return values;
 }
 
 template <typename T>
-void call_std_sort(vector<T> & v)
+bool check_front_end(const vector<T> & input)
 {
-   std::sort(v.begin(), v.end());
+    return check_front_end_values(input) &&
+           check_front_end_values(bits_as<long long>(input)) &&
+           check_front_end_values(bits_as<long>(input)) &&
+           check_front_end_values(bits_as<unsigned long long>(input)) &&
+           check_front_end_values(bits_as<char>(input));
 }
 
+// Returns the name of the first entry point whose result is wrong, null if all are right.
 template <typename T>
-bool sorted_and_equal(const vector<T> & sorted, vector<T>& original)
+const char* failed_check(const vector<T> & input)
 {
-    assert(sorted.size() == original.size());
+    typedef integral_constant<bool, sizeof(T) != 1> wide;
 
-    std::sort(original.begin(), original.end());
+    if (!check_descending(input))
+        return "radix_sort descending";
 
-    for(unsigned i = 0; i < sorted.size(); ++i)
-        if (sorted[i] != original[i])
-            return false;
+    if (!check_parallel(input, wide()))
+        return "radix_sort_parallel";
 
-    return true;
+    if (!check_shared(input, wide()))
+        return "radix_sort_shared";
+
+    if (!check_payload(input, wide()))
+        return "radix_sort_with_payload";
+
+    if (!check_in_place(input))
+        return "radix_sort_in_place";
+
+    if (!check_merge_batch(input, wide()))
+        return "radix_sort_merge_batch";
+
+    if (!check_unique(input))
+        return "radix_sort_unique or radix_sort_counts";
+
+    if (!check_composite_keys(input))
+        return "radix_sort of 128 bit or composite keys";
+
+    if (!check_file(input, wide()))
+        return "radix_sort_file";
+
+    if (!check_strings(input))
+        return "radix_sort of strings";
+
+    if (!check_by_key(input))
+        return "radix_sort_by_key";
+
+    if (!check_builder(input))
+        return "radix_sort_builder";
+
+    if (!check_front_end(input))
+        return "radix_sort front end";
+
+    if (!check_segmented(input))
+        return "radix_sort_segmented";
+
+    if (!input.empty() && !check_select(input))
+        return "radix_nth_element, radix_top_k or radix_partial_sort";
+
+    return nullptr;
+}
+
+struct benchmark_options
+{
+    unsigned min_elements = 16;
+    size_t max_bytes = size_t(256) << 20;
+    unsigned trials = 11;
+    unsigned warmup = 1;
+    string types;
+    string distributions;
+    string algorithms;
+    bool counters = false;
+    bool check_only = false;
+    unsigned seed = 42;
+};
+
+// Empty list selects everything.
+bool selected(const string & list, const string & name)
+{
+    return list.empty() || ("," + list + ",").find("," + name + ",") != string::npos;
 }
 
 template <typename T>
@@ -42,65 +1255,356 @@ class random_values
 {
 private:
 
-    mt19937 generator;
-
     using Distribution = typename conditional<is_integral<T>::value,
-            uniform_int_distribution<T>,
+            uniform_int_distribution<typename conditional<(sizeof(T) < sizeof(int)), int, T>::type>,
             uniform_real_distribution<T>>::type;
 
     Distribution distribution;
 
 public:
 
-    random_values()
+    static T min_value()
     {
-        random_device rd;
-        generator = mt19937(rd());
-        distribution = Distribution(numeric_limits<T>::min(), numeric_limits<T>::max());
+        return is_integral<T>::value ? numeric_limits<T>::min() : numeric_limits<T>::lowest() / 2;
     }
 
-    T operator()()
+    static T max_value()
     {
-        return distribution(generator);
+        return is_integral<T>::value ? numeric_limits<T>::max() : numeric_limits<T>::max() / 2;
+    }
+
+    random_values() : distribution(min_value(), max_value())
+    {
+    }
+
+    T operator()(mt19937_64 & generator)
+    {
+        return T(distribution(generator));
     }
 };
 
-template <typename T, typename F>
-double test(string function_name, F sorting_function, const unsigned num_of_elements, T)
+// Input distributions. Every generator fills the whole vector.
+template <typename T>
+void uniform(vector<T> & values, mt19937_64 & generator)
 {
-    vector<T> main(num_of_elements);
-
     random_values<T> random_value;
 
-    generate(main.begin(), main.end(), random_value);
+    for (auto & value : values)
+        value = random_value(generator);
+}
+
+template <typename T>
+void sorted(vector<T> & values, mt19937_64 & generator)
+{
+    uniform(values, generator);
+    std::sort(values.begin(), values.end(), expected_less());
+}
+
+template <typename T>
+void reverse_sorted(vector<T> & values, mt19937_64 & generator)
+{
+    sorted(values, generator);
+    std::reverse(values.begin(), values.end());
+}
+
+// Sorted, then 1% of the elements swapped with random other ones.
+template <typename T>
+void nearly_sorted(vector<T> & values, mt19937_64 & generator)
+{
+    sorted(values, generator);
+
+    if (values.empty())
+        return;
+
+    uniform_int_distribution<size_t> position(0, values.size() - 1);
 
-    vector<T> copy = main;
+    for (size_t i = 0; i < values.size() / 100; ++i)
+        swap(values[position(generator)], values[position(generator)]);
+}
 
-    clock_t start = clock();
+// 16 distinct values.
+template <typename T>
+void few_unique(vector<T> & values, mt19937_64 & generator)
+{
+    vector<T> unique(16);
+    uniform(unique, generator);
 
-    sorting_function(main);
+    uniform_int_distribution<unsigned> index(0, unsigned(unique.size() - 1));
 
-    double total = (clock() - start) / double(CLOCKS_PER_SEC);
+    for (auto & value : values)
+        value = unique[index(generator)];
+}
 
-    cout << function_name << " | Time " << total <<
-         " sec";
+// Zipf distribution (s = 1) over up to 2^20 distinct random values.
+template <typename T>
+void zipf(vector<T> & values, mt19937_64 & generator)
+{
+    vector<T> unique(max(size_t(1), min(values.size(), size_t(1) << 20)));
+    uniform(unique, generator);
 
-    if(!main.empty())
-        cout << ", random element: " << (long double)main[rand() % main.size()];
+    vector<double> cumulative(unique.size());
 
-    cout << endl;
+    double sum = 0;
 
-    // Verification of sorting.
-    // Proves that sorted array is equal to original array, sorted with std::sort.
-    if(!sorted_and_equal(main, copy))
+    for (size_t rank = 0; rank < unique.size(); ++rank)
     {
-        cout << function_name << ": data is not sorted" << endl;
-        exit(1);
+        sum += 1.0 / double(rank + 1);
+        cumulative[rank] = sum;
+    }
+
+    uniform_real_distribution<double> probability(0, sum);
+
+    for (auto & value : values)
+    {
+        const size_t rank = upper_bound(cumulative.begin(), cumulative.end(), probability(generator)) - cumulative.begin();
+        value = unique[min(rank, unique.size() - 1)];
+    }
+}
+
+// Values from 0 to 999 (to 127 for 8 bit types).
+template <typename T>
+void small_range(vector<T> & values, mt19937_64 & generator)
+{
+    uniform_int_distribution<int> distribution(0, is_integral<T>::value && sizeof(T) == 1 ? 127 : 999);
+
+    for (auto & value : values)
+        value = T(distribution(generator));
+}
+
+// Floating point values of both signs around zero,
+// with some -0.0, +0.0 and NaN mixed in.
+template <typename T>
+void mixed_sign(vector<T> & values, mt19937_64 & generator)
+{
+    typedef typename conditional<is_floating_point<T>::value, T, double>::type real_type;
+
+    uniform_real_distribution<real_type> distribution(-1000, 1000);
+    uniform_int_distribution<unsigned> special(0, 999);
+
+    for (auto & value : values)
+    {
+        switch (special(generator))
+        {
+            case 0: value = T(-0.0); break;
+            case 1: value = T(0.0); break;
+            case 2: value = T(numeric_limits<real_type>::quiet_NaN()); break;
+            default: value = T(distribution(generator));
+        }
+    }
+}
+
+template <typename T>
+struct distribution_data
+{
+    const char* name;
+    void (*generate)(vector<T> &, mt19937_64 &);
+};
+
+template <typename T>
+vector<distribution_data<T>> distributions()
+{
+    vector<distribution_data<T>> result =
+    {
+        { "uniform", uniform<T> },
+        { "sorted", sorted<T> },
+        { "reverse_sorted", reverse_sorted<T> },
+        { "nearly_sorted", nearly_sorted<T> },
+        { "few_unique", few_unique<T> },
+        { "zipf", zipf<T> },
+        { "small_range", small_range<T> },
+    };
+
+    if (is_floating_point<T>::value)
+        result.push_back(distribution_data<T>{ "mixed_sign", mixed_sign<T> });
+
+    return result;
+}
+
+// Hardware counters of the calling thread, from perf_event_open.
+// Counters the kernel or the CPU doesn't provide are left out.
+class perf_counters
+{
+private:
+
+    struct counter
+    {
+        const char* name;
+        int fd;
+    };
+
+    vector<counter> counters;
+
+public:
+
+    perf_counters()
+    {
+#ifdef __linux__
+        const uint64_t dtlb_load_misses = PERF_COUNT_HW_CACHE_DTLB
+            | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+        const struct { const char* name; uint32_t type; uint64_t config; } events[] =
+        {
+            { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { "cache_references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+            { "cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+            { "dtlb_load_misses", PERF_TYPE_HW_CACHE, dtlb_load_misses },
+        };
+
+        for (const auto & event : events)
+        {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = event.type;
+            attr.config = event.config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            const int fd = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+
+            if (fd >= 0)
+                counters.push_back(counter{ event.name, fd });
+        }
+#endif
+    }
+
+    ~perf_counters()
+    {
+#ifdef __linux__
+        for (const auto & c : counters)
+            close(c.fd);
+#endif
+    }
+
+    perf_counters(const perf_counters &) = delete;
+    perf_counters & operator=(const perf_counters &) = delete;
+
+    bool available() const
+    {
+        return !counters.empty();
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        for (const auto & c : counters)
+        {
+            ioctl(c.fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(c.fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // Stops counting and returns the counts as a JSON object.
+    string stop()
+    {
+        ostringstream json;
+        json << "{";
+
+#ifdef __linux__
+        for (const auto & c : counters)
+            ioctl(c.fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        for (size_t i = 0; i < counters.size(); ++i)
+        {
+            uint64_t value = 0;
+
+            if (read(counters[i].fd, &value, sizeof(value)) != ssize_t(sizeof(value)))
+                value = 0;
+
+            json << (i ? ", " : "") << "\"" << counters[i].name << "\": " << value;
+        }
+#endif
+
+        json << "}";
+        return json.str();
+    }
+};
+
+
+template <typename T>
+void call_radix_sort(T* values, unsigned count, T* temp)
+{
+    radix_sort_ordered(values, count, temp, radix_sort_order::ascending);
+}
+
+// Collects the hardware counters of every phase of radix_sort_lsd_impl.
+class counting_observer
+{
+private:
+
+    perf_counters & counters;
+
+    ostringstream json;
+
+public:
+
+    explicit counting_observer(perf_counters & counters) : counters(counters)
+    {
+    }
+
+    void phase_begin(radix_sort_phase, unsigned)
+    {
+        counters.start();
     }
 
-    return total;
+    void phase_end(radix_sort_phase phase, unsigned pass, size_t bytes_moved)
+    {
+        static const char* const names[] = { "histogram", "offset_table", "scatter", "merge", "copy_back" };
+
+        const string values = counters.stop();
+
+        json << (json.tellp() ? ", " : "")
+             << "{\"phase\": \"" << names[unsigned(phase)] << "\""
+             << ", \"pass\": " << pass
+             << ", \"bytes_moved\": " << bytes_moved
+             << ", \"counters\": " << values << "}";
+    }
+
+    void digit_histogram(unsigned, const unsigned*, unsigned, bool)
+    {
+    }
+
+    // JSON array of all phases.
+    string phases() const
+    {
+        return "[" + json.str() + "]";
+    }
+};
+
+// The same sort as call_radix_sort, with an observer.
+template <typename T>
+void call_radix_sort_observed(T* values, unsigned count, T* temp, counting_observer & observer)
+{
+    radix_sort_lsd_impl<RADIX_SORT_DIGIT_BITS>(values, count, temp, radix_sort_transform(), observer);
+}
+
+template <typename T>
+void call_std_sort(T* values, unsigned count, T*)
+{
+    std::sort(values, values + count, expected_less());
+}
+
+template <typename T>
+void call_std_stable_sort(T* values, unsigned count, T*)
+{
+    std::stable_sort(values, values + count, expected_less());
 }
 
+template <typename T>
+struct algorithm_data
+{
+    const char* name;
+    void (*sort)(T*, unsigned, T*);
+    bool verify;
+
+    // Per-pass counters are only collected for sorts with passes.
+    void (*observed_sort)(T*, unsigned, T*, counting_observer &);
+};
+
 template<typename T>
 struct TypeData;
 
@@ -116,44 +1620,252 @@ REGISTER_TYPE_NAME(uint32_t);
 REGISTER_TYPE_NAME(uint64_t);
 REGISTER_TYPE_NAME(int64_t);
 REGISTER_TYPE_NAME(float);
+REGISTER_TYPE_NAME(double);
+
+// Nearest rank percentile of sorted times.
+double percentile(const vector<double> & sorted_times, const double p)
+{
+    const size_t rank = size_t(ceil(p * double(sorted_times.size())));
+
+    return sorted_times[rank ? rank - 1 : 0];
+}
+
+bool first_result = true;
 
 template <typename T>
-void run_test(const unsigned number_of_elements)
+void run_benchmark(const benchmark_options & options, const distribution_data<T> & distribution,
+                   const algorithm_data<T> & algorithm, const unsigned count, const vector<T> & input)
 {
-    cout << "Type: vector<" << TypeData<T>::name << ">" << endl;
+    // Small arrays are sorted batch_size times per timed interval,
+    // each time a separate copy of the input.
+    const unsigned batch_size = max(1U, (1U << 16) / max(count, 1U));
 
-    const long double min_value = numeric_limits<T>::min();
-    const long double max_value = numeric_limits<T>::max();
+    vector<T> batch(size_t(count) * batch_size);
+    vector<T> temp(count);
 
-    cout << "Contains uniformly distributed values from " << min_value << " to " << max_value << endl;
+    auto run = [&]() -> double
+    {
+        for (unsigned b = 0; b < batch_size; ++b)
+            copy(input.begin(), input.end(), batch.begin() + size_t(b) * count);
+
+        auto start = chrono::steady_clock::now();
+
+        for (unsigned b = 0; b < batch_size; ++b)
+            algorithm.sort(batch.data() + size_t(b) * count, count, temp.data());
+
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count() / batch_size;
+    };
+
+    double warmup_time = 0;
+
+    for (unsigned w = 0; w < max(options.warmup, 1U); ++w)
+        warmup_time = run();
+
+    // Verification of sorting.
+    // Proves that sorted array is equal to original array, sorted with std::sort.
+    if (algorithm.verify && !sorted_and_equal(vector<T>(batch.begin(), batch.begin() + count), input))
+    {
+        cerr << TypeData<T>::name << " " << distribution.name << " " << count << ": data is not sorted" << endl;
+        exit(1);
+    }
+
+    // Trials are cut down to about 10 seconds, but not below 3.
+    unsigned trials = options.trials;
+
+    if (warmup_time * trials > 10.0)
+        trials = max(3U, unsigned(10.0 / warmup_time));
+
+    vector<double> times;
+
+    for (unsigned t = 0; t < trials; ++t)
+        times.push_back(run());
+
+    sort(times.begin(), times.end());
+
+    const double median = percentile(times, 0.5);
+
+    cout << (first_result ? "" : ",\n")
+         << "    {\"type\": \"" << TypeData<T>::name << "\""
+         << ", \"distribution\": \"" << distribution.name << "\""
+         << ", \"elements\": " << count
+         << ", \"bytes\": " << size_t(count) * sizeof(T)
+         << ", \"algorithm\": \"" << algorithm.name << "\""
+         << ", \"trials\": " << trials
+         << ", \"median_ns\": " << median * 1e9
+         << ", \"p99_ns\": " << percentile(times, 0.99) * 1e9
+         << ", \"elements_per_sec\": " << (median > 0 ? count / median : 0.0);
+
+    if (options.counters)
+    {
+        perf_counters counters;
+
+        for (unsigned b = 0; b < batch_size; ++b)
+            copy(input.begin(), input.end(), batch.begin() + size_t(b) * count);
+
+        counters.start();
+
+        for (unsigned b = 0; b < batch_size; ++b)
+            algorithm.sort(batch.data() + size_t(b) * count, count, temp.data());
+
+        cout << ", \"counters\": " << counters.stop() << ", \"counted_sorts\": " << batch_size;
+
+        if (algorithm.observed_sort)
+        {
+            counting_observer observer(counters);
+
+            copy(input.begin(), input.end(), batch.begin());
+
+            algorithm.observed_sort(batch.data(), count, temp.data(), observer);
+
+            cout << ", \"pass_counters\": " << observer.phases();
+        }
+    }
+
+    cout << "}" << flush;
+
+    first_result = false;
 
-    const double radix_time = test("Radix sort", call_radix_sort<T>, number_of_elements, T());
+    cerr << TypeData<T>::name << "\t" << distribution.name << "\t" << count << "\t"
+         << algorithm.name << "\t" << median * 1e9 << " ns" << endl;
+}
+
+template <typename T>
+void run_test(const benchmark_options & options)
+{
+    if (!selected(options.types, TypeData<T>::name))
+        return;
+
+    const algorithm_data<T> algorithms[] =
+    {
+        // radix_sort of 8 bit types is a single counting pass
+        { "radix_sort", call_radix_sort, true, sizeof(T) == 1 ? nullptr : call_radix_sort_observed<T> },
+        { "std::sort", call_std_sort<T>, false, nullptr },
+        { "std::stable_sort", call_std_stable_sort<T>, false, nullptr },
+    };
+
+    mt19937_64 generator(options.seed);
+
+    for (const auto & distribution : distributions<T>())
+    {
+        if (!selected(options.distributions, distribution.name))
+            continue;
+
+        for (size_t count = options.min_elements;
+             count * sizeof(T) <= options.max_bytes && count <= UINT_MAX &&
+             (!options.check_only || count <= check_max_elements);
+             count *= 8)
+        {
+            vector<T> input(count);
+            distribution.generate(input, generator);
 
-    const double std_sort_time = test("std::sort ", call_std_sort<T>, number_of_elements, T());
+            const char* failed = count <= check_max_elements ? failed_check(input) : nullptr;
 
-    cout << "Radix sort is " <<
-        max(std_sort_time, radix_time) / min(std_sort_time, radix_time) <<
-        " times " << (std_sort_time > radix_time ? "faster" : "slower") << endl << endl;
+            if (failed)
+            {
+                cerr << TypeData<T>::name << " " << distribution.name << " " << count << ": " << failed
+                     << " result is wrong" << endl;
+                exit(1);
+            }
+
+            for (const auto & algorithm : algorithms)
+                if (!options.check_only && selected(options.algorithms, algorithm.name))
+                    run_benchmark(options, distribution, algorithm, unsigned(count), input);
+        }
+    }
 }
 
 template <typename T>
-void run_tests(const unsigned number_of_elements)
+void run_tests(const benchmark_options & options)
 {
-    run_test<T>(number_of_elements);
+    run_test<T>(options);
 }
 
 template <typename T1, typename T2, typename ... Ts>
-void run_tests(const unsigned number_of_elements)
+void run_tests(const benchmark_options & options)
 {
-    run_test<T1>(number_of_elements);
-    run_tests<T2, Ts...>(number_of_elements);
+    run_test<T1>(options);
+    run_tests<T2, Ts...>(options);
+}
+
+// Number with an optional K, M or G suffix.
+size_t parse_size(const char* text)
+{
+    char* end = nullptr;
+    size_t value = strtoull(text, &end, 10);
+
+    switch (*end)
+    {
+        case 'G': case 'g': value <<= 10; // fall through
+        case 'M': case 'm': value <<= 10; // fall through
+        case 'K': case 'k': value <<= 10;
+    }
+
+    return value;
 }
 
-int main()
+int main(int argc, char** argv)
 {
-    const unsigned num_of_elements = 50000000U;
+    benchmark_options options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : "";
+
+        if (arg == "--counters")
+            options.counters = true;
+        else if (arg == "--check-only")
+            options.check_only = true;
+        else if (i + 1 == argc)
+        {
+            cerr << "Unknown option or missing value: " << arg << endl;
+            return 1;
+        }
+        else if (arg == "--min-elements")
+            options.min_elements = max(1U, unsigned(parse_size(argv[++i])));
+        else if (arg == "--max-bytes")
+            options.max_bytes = parse_size(argv[++i]);
+        else if (arg == "--trials")
+            options.trials = max(1U, unsigned(atoi(argv[++i])));
+        else if (arg == "--warmup")
+            options.warmup = unsigned(atoi(argv[++i]));
+        else if (arg == "--types")
+            options.types = argv[++i];
+        else if (arg == "--distributions")
+            options.distributions = argv[++i];
+        else if (arg == "--algorithms")
+            options.algorithms = argv[++i];
+        else if (arg == "--seed")
+            options.seed = unsigned(atoi(argv[++i]));
+        else
+        {
+            cerr << "Unknown option: " << arg << " " << value << endl;
+            return 1;
+        }
+    }
+
+    if (options.counters && !perf_counters().available())
+        cerr << "Hardware counters are not available, counters will be empty" << endl;
 
-    cout << "Number of elements: " << num_of_elements << endl;
+    if (!check_nested_prefixes())
+    {
+        cerr << "radix_sort of nested prefixes: result is wrong" << endl;
+        return 1;
+    }
+
+    if (!check_stats())
+    {
+        cerr << "radix_sort_stats: reported passes or bytes are wrong" << endl;
+        return 1;
+    }
+
+    if (!options.check_only)
+        cout << "{\n  \"min_elements\": " << options.min_elements
+             << ",\n  \"max_bytes\": " << options.max_bytes
+             << ",\n  \"trials\": " << options.trials
+             << ",\n  \"warmup\": " << options.warmup
+             << ",\n  \"seed\": " << options.seed
+             << ",\n  \"results\": [\n";
 
     run_tests<int8_t,
             uint8_t,
@@ -163,6 +1875,12 @@ int main()
             uint32_t,
             uint64_t,
             int64_t,
-            float
-            >(num_of_elements);
-}
\ No newline at end of file
+            float,
+            double
+            >(options);
+
+    if (options.check_only)
+        cerr << "All checks passed" << endl;
+    else
+        cout << "\n  ]\n}" << endl;
+}
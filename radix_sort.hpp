@@ -1,5 +1,32 @@
 #include <cstdint>
 #include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 #ifndef RADIX_SORT_H
 #define RADIX_SORT_H
@@ -32,14 +59,12 @@ const unsigned values_in_byte = 1U << CHAR_BIT;
 
 const unsigned lsb_mask = values_in_byte - 1;
 
-#define byte0(value) ((value) & lsb_mask)
-#define byte1(value) (((value) >> CHAR_BIT) & lsb_mask)
-#define byte2(value) (((value) >> (2 * CHAR_BIT)) & lsb_mask)
-#define byte3(value) (((value) >> (3 * CHAR_BIT)) & lsb_mask)
-#define byte4(value) (((value) >> (4 * CHAR_BIT)) & lsb_mask)
-#define byte5(value) (((value) >> (5 * CHAR_BIT)) & lsb_mask)
-#define byte6(value) (((value) >> (6 * CHAR_BIT)) & lsb_mask)
-#define byte7(value) ((value) >> (7 * CHAR_BIT))
+// Width of a digit, in bits, used by the public overloads.
+// Wider digits mean fewer passes, but larger histograms:
+// 8 bits - 256 buckets, 11 bits - 2048 buckets, 16 bits - 65536 buckets.
+#ifndef RADIX_SORT_DIGIT_BITS
+#define RADIX_SORT_DIGIT_BITS 8
+#endif
 
 #define COPY_WITH_REORDERING_UNROLLED(src, src_end, dst, hist, extract_byte_f) \
     { \
@@ -64,604 +89,3527 @@ const unsigned lsb_mask = values_in_byte - 1;
         } \
     }
 
-inline void radix_sort_calculate_offset_table_16(unsigned* hist0, unsigned* hist1)
+// Extracts the digit of radix_bits bits at shift from a transformed key.
+template <unsigned radix_bits>
+struct radix_sort_digit
 {
-    unsigned offset0 = 0;
-    unsigned offset1 = 0;
- 
-     for (unsigned int i = 0; i < values_in_byte; i += 4)
-    {
-        unsigned temp_offset = hist0[i] + offset0;
-        hist0[i] = offset0 - 1; 
-        offset0 = temp_offset;
-        
-        temp_offset = hist0[i+1] + offset0; 
-        hist0[i+1] = offset0 - 1; 
-        offset0 = temp_offset;
-        
-        temp_offset = hist0[i+2] + offset0; 
-        hist0[i+2] = offset0 - 1; 
-        offset0 = temp_offset;
-        
-        temp_offset = hist0[i+3] + offset0; 
-        hist0[i+3] = offset0 - 1; 
-        offset0 = temp_offset;
-
-        temp_offset = hist1[i] + offset1; 
-        hist1[i] = offset1 - 1; 
-        offset1 = temp_offset;
-        
-        temp_offset = hist1[i+1] + offset1; 
-        hist1[i+1] = offset1 - 1; 
-        offset1 = temp_offset;
-        
-        temp_offset = hist1[i+2] + offset1; 
-        hist1[i+2] = offset1 - 1; 
-        offset1 = temp_offset;
-        
-        temp_offset = hist1[i+3] + offset1; 
-        hist1[i+3] = offset1 - 1; 
-        offset1 = temp_offset;
-    }
-}
-
-inline void radix_sort_calculate_offset_table_32(unsigned* hist0, unsigned* hist1,
-                                                 unsigned* hist2, unsigned* hist3)
-{
-    unsigned offset0 = 0;
-    unsigned offset1 = 0; 
-    unsigned offset2 = 0;
-    unsigned offset3 = 0;
-
-    for (unsigned i = 0; i < values_in_byte; i += 4)
-    {
-        unsigned temp_offset = hist0[i] + offset0;
-        hist0[i] = offset0 - 1;
-        offset0 = temp_offset;
-
-        temp_offset = hist0[i+1] + offset0;
-        hist0[i+1] = offset0 - 1;
-        offset0 = temp_offset;
-
-        temp_offset = hist0[i+2] + offset0;
-        hist0[i+2] = offset0 - 1; 
-        offset0 = temp_offset;
-        
-        temp_offset = hist0[i+3] + offset0;
-        hist0[i+3] = offset0 - 1;
-        offset0 = temp_offset;
-
-        temp_offset = hist1[i] + offset1;
-        hist1[i] = offset1 - 1;
-        offset1 = temp_offset;
-
-        temp_offset = hist1[i+1] + offset1;
-        hist1[i+1] = offset1 - 1;
-        offset1 = temp_offset;
-
-        temp_offset = hist1[i+2] + offset1;
-        hist1[i+2] = offset1 - 1;
-        offset1 = temp_offset;
-
-        temp_offset = hist1[i+3] + offset1;
-        hist1[i+3] = offset1 - 1;
-        offset1 = temp_offset;
-
-        temp_offset = hist2[i] + offset2;
-        hist2[i] = offset2 - 1;
-        offset2 = temp_offset;
-
-        temp_offset = hist2[i+1] + offset2;
-        hist2[i+1] = offset2 - 1;
-        offset2 = temp_offset;
-
-        temp_offset = hist2[i+2] + offset2;
-        hist2[i+2] = offset2 - 1;
-        offset2 = temp_offset;
-
-        temp_offset = hist2[i+3] + offset2;
-        hist2[i+3] = offset2 - 1;
-        offset2 = temp_offset;
-
-        temp_offset = hist3[i] + offset3;
-        hist3[i] = offset3 - 1;
-        offset3 = temp_offset;
-
-        temp_offset = hist3[i+1] + offset3;
-        hist3[i+1] = offset3 - 1;
-        offset3 = temp_offset;
-
-        temp_offset = hist3[i+2] + offset3;
-        hist3[i+2] = offset3 - 1;
-        offset3 = temp_offset;
-
-        temp_offset = hist3[i+3] + offset3;
-        hist3[i+3] = offset3 - 1;
-        offset3 = temp_offset;
-    }
-}
-
-inline void radix_sort_calculate_offset_table_64(unsigned* hist0, unsigned* hist1,
-                                                 unsigned* hist2, unsigned* hist3,
-                                                 unsigned* hist4, unsigned* hist5,
-                                                 unsigned* hist6, unsigned* hist7)
-{
-    unsigned offset0 = 0;
-    unsigned offset1 = 0;
-    unsigned offset2 = 0;
-    unsigned offset3 = 0;
-    unsigned offset4 = 0;
-    unsigned offset5 = 0;
-    unsigned offset6 = 0;
-    unsigned offset7 = 0;
-
-    for (unsigned int i = 0; i < values_in_byte; i += 4)
-    {
-        unsigned temp_offset = hist0[i] + offset0; 
-        hist0[i] = offset0 - 1; 
-        offset0 = temp_offset;
-        
-        temp_offset = hist0[i+1] + offset0; 
-        hist0[i+1] = offset0 - 1; 
-        offset0 = temp_offset;
-        
-        temp_offset = hist0[i+2] + offset0; 
-        hist0[i+2] = offset0 - 1; 
-        offset0 = temp_offset;
-        
-        temp_offset = hist0[i+3] + offset0; 
-        hist0[i+3] = offset0 - 1; 
-        offset0 = temp_offset;
-
-        temp_offset = hist1[i] + offset1; 
-        hist1[i] = offset1 - 1; 
-        offset1 = temp_offset;
-        
-        temp_offset = hist1[i+1] + offset1; 
-        hist1[i+1] = offset1 - 1; 
-        offset1 = temp_offset;
-        
-        temp_offset = hist1[i+2] + offset1; 
-        hist1[i+2] = offset1 - 1; 
-        offset1 = temp_offset;
-        
-        temp_offset = hist1[i+3] + offset1; 
-        hist1[i+3] = offset1 - 1; 
-        offset1 = temp_offset;
-
-        temp_offset = hist2[i] + offset2; 
-        hist2[i] = offset2 - 1; 
-        offset2 = temp_offset;
-        
-        temp_offset = hist2[i+1] + offset2; 
-        hist2[i+1] = offset2 - 1; 
-        offset2 = temp_offset;
-        
-        temp_offset = hist2[i+2] + offset2; 
-        hist2[i+2] = offset2 - 1; 
-        offset2 = temp_offset;
-        
-        temp_offset = hist2[i+3] + offset2; 
-        hist2[i+3] = offset2 - 1; 
-        offset2 = temp_offset;
-
-        temp_offset = hist3[i] + offset3; 
-        hist3[i] = offset3 - 1; 
-        offset3 = temp_offset;
-        
-        temp_offset = hist3[i+1] + offset3; 
-        hist3[i+1] = offset3 - 1; 
-        offset3 = temp_offset;
-        
-        temp_offset = hist3[i+2] + offset3; 
-        hist3[i+2] = offset3 - 1; 
-        offset3 = temp_offset;
-        
-        temp_offset = hist3[i+3] + offset3; 
-        hist3[i+3] = offset3 - 1; 
-        offset3 = temp_offset;
-
-        temp_offset = hist4[i] + offset4; 
-        hist4[i] = offset4 - 1; 
-        offset4 = temp_offset;
-        
-        temp_offset = hist4[i+1] + offset4; 
-        hist4[i+1] = offset4 - 1; 
-        offset4 = temp_offset;
-        
-        temp_offset = hist4[i+2] + offset4; 
-        hist4[i+2] = offset4 - 1; 
-        offset4 = temp_offset;
-        
-        temp_offset = hist4[i+3] + offset4; 
-        hist4[i+3] = offset4 - 1; 
-        offset4 = temp_offset;
-
-        temp_offset = hist5[i] + offset5; 
-        hist5[i] = offset5 - 1; 
-        offset5 = temp_offset;
-        
-        temp_offset = hist5[i+1] + offset5; 
-        hist5[i+1] = offset5 - 1; 
-        offset5 = temp_offset;
-        
-        temp_offset = hist5[i+2] + offset5; 
-        hist5[i+2] = offset5 - 1; 
-        offset5 = temp_offset;
-        
-        temp_offset = hist5[i+3] + offset5; 
-        hist5[i+3] = offset5 - 1; 
-        offset5 = temp_offset;
-
-        temp_offset = hist6[i] + offset6; 
-        hist6[i] = offset6 - 1; 
-        offset6 = temp_offset;
-        
-        temp_offset = hist6[i+1] + offset6; 
-        hist6[i+1] = offset6 - 1; 
-        offset6 = temp_offset;
-        
-        temp_offset = hist6[i+2] + offset6; 
-        hist6[i+2] = offset6 - 1; 
-        offset6 = temp_offset;
-        
-        temp_offset = hist6[i+3] + offset6; 
-        hist6[i+3] = offset6 - 1; 
-        offset6 = temp_offset;
-
-        temp_offset = hist7[i] + offset7; 
-        hist7[i] = offset7 - 1; 
-        offset7 = temp_offset;
-        
-        temp_offset = hist7[i+1] + offset7; 
-        hist7[i+1] = offset7 - 1; 
-        offset7 = temp_offset;
-        
-        temp_offset = hist7[i+2] + offset7; 
-        hist7[i+2] = offset7 - 1; 
-        offset7 = temp_offset;
-        
-        temp_offset = hist7[i+3] + offset7; 
-        hist7[i+3] = offset7 - 1; 
-        offset7 = temp_offset;
+    static const unsigned buckets = 1U << radix_bits;
+
+    unsigned shift;
+
+    explicit radix_sort_digit(unsigned shift) : shift(shift) { }
+
+    template <typename U>
+    unsigned operator()(U value) const
+    {
+        return unsigned(value >> shift) & (buckets - 1);
+    }
+};
+
+// A column that is reordered together with the keys.
+// data holds the values, temp is a buffer of the same size.
+// Both are swapped after every reordering pass, so that after
+// an even number of passes the result is back in data.
+template <typename P>
+struct radix_sort_payload
+{
+    P* data;
+    P* temp;
+
+    radix_sort_payload(P* data, P* temp) : data(data), temp(temp) { }
+
+    radix_sort_payload swapped() const
+    {
+        return radix_sort_payload(temp, data);
     }
+};
+
+template <typename P>
+radix_sort_payload<P> radix_sort_make_payload(P* data, P* temp)
+{
+    return radix_sort_payload<P>(data, temp);
 }
 
-template <typename T, typename F>
-void radix_sort_16_impl(T* src, unsigned count, T* dst, F bitwise_transform)
+inline void radix_sort_move_payload(unsigned, unsigned)
 {
-    unsigned histograms[2][values_in_byte] = { 0 };
+}
 
-    unsigned* hist0 = histograms[0];
-    unsigned* hist1 = histograms[1];
+template <typename P, typename... Ps>
+inline void radix_sort_move_payload(unsigned from, unsigned to,
+                                    radix_sort_payload<P> payload, radix_sort_payload<Ps>... rest)
+{
+    payload.temp[to] = payload.data[from];
+    radix_sort_move_payload(from, to, rest...);
+}
 
+// Scatter strategy of the reordering passes:
+// RADIX_SORT_SCATTER_DIRECT   - every element is written straight to its slot,
+// RADIX_SORT_SCATTER_BUFFERED - elements are staged in cache line sized
+//                               per-bucket buffers, written out a line at a time,
+// RADIX_SORT_SCATTER_AUTO     - buffered for arrays of at least
+//                               RADIX_SORT_BUFFERED_SCATTER_THRESHOLD bytes.
+#define RADIX_SORT_SCATTER_DIRECT 0
+#define RADIX_SORT_SCATTER_BUFFERED 1
+#define RADIX_SORT_SCATTER_AUTO 2
+
+#ifndef RADIX_SORT_SCATTER
+#define RADIX_SORT_SCATTER RADIX_SORT_SCATTER_AUTO
+#endif
+
+// Roughly the size of the last level cache, above it direct scatter
+// spends most of its time on cache and TLB misses.
+#ifndef RADIX_SORT_BUFFERED_SCATTER_THRESHOLD
+#define RADIX_SORT_BUFFERED_SCATTER_THRESHOLD (8U << 20)
+#endif
+
+// Full lines of the buffered scatter are written with non-temporal stores,
+// which don't pull destination lines into the cache.
+#ifndef RADIX_SORT_NON_TEMPORAL_STORES
+#if defined(__SSE2__) || defined(_M_X64)
+#define RADIX_SORT_NON_TEMPORAL_STORES 1
+#else
+#define RADIX_SORT_NON_TEMPORAL_STORES 0
+#endif
+#endif
+
+const unsigned cache_line_size = 64;
+
+template <typename T, typename F, typename E>
+inline void radix_sort_scatter_direct(T* src, const unsigned count, T* dst, unsigned* hist,
+                                      F bitwise_transform, E extract_byte)
+{
     T* src_end = src + count;
-    T* dst_end = dst + count;
 
-    unsigned unroll_count = count >> 2;
+    COPY_WITH_REORDERING_UNROLLED(src, src_end, dst, hist, extract_byte);
+}
 
-    T* i = src;
+template <bool non_temporal>
+inline void radix_sort_write_line(void* dst, const void* line)
+{
+#if RADIX_SORT_NON_TEMPORAL_STORES
+    if (non_temporal)
+    {
+        const __m128i* from = static_cast<const __m128i*>(line);
+        __m128i* to = static_cast<__m128i*>(dst);
+
+        _mm_stream_si128(to, _mm_load_si128(from));
+        _mm_stream_si128(to + 1, _mm_load_si128(from + 1));
+        _mm_stream_si128(to + 2, _mm_load_si128(from + 2));
+        _mm_stream_si128(to + 3, _mm_load_si128(from + 3));
+        return;
+    }
+#endif
 
-    for (; unroll_count; --unroll_count, i += 4)
+    std::memcpy(dst, line, cache_line_size);
+}
+
+// Emit policy of the scatters: decides for every element whether it is
+// written, and follows the elements it keeps. emit(key, value, pending,
+// written) is called with the key and the digit of an element, the number
+// of elements of its bucket waiting in a buffer and the last slot written
+// for the bucket; written(value, first, count) after count elements of the
+// bucket went to slots first .. first + count - 1. This one keeps every element.
+struct radix_sort_emit_all
+{
+    template <typename K>
+    bool emit(const K&, unsigned, unsigned, unsigned) { return true; }
+
+    void written(unsigned, unsigned, unsigned) { }
+};
+
+// Software write-combining scatter. Every bucket collects elements in its
+// own cache line sized buffer; a full buffer is written to dst at once.
+// The first write of a bucket is shortened so that all following ones
+// start at a cache line boundary of dst, which lets full lines go out
+// with non-temporal stores. hist is used the same way as by the direct scatter.
+template <bool non_temporal, typename T, typename F, typename E, typename S>
+void radix_sort_scatter_buffered(T* src, const unsigned count, T* dst, unsigned* hist,
+                                 F bitwise_transform, E extract_byte, S& emit)
+{
+    static_assert(cache_line_size % sizeof(T) == 0, "element size must divide the cache line size");
+
+    const unsigned line_elements = cache_line_size / sizeof(T);
+
+    struct line
     {
-        auto element0 = bitwise_transform(*i);
-        auto element1 = bitwise_transform(*(i+1));
-        auto element2 = bitwise_transform(*(i+2));
-        auto element3 = bitwise_transform(*(i+3));
+        alignas(64) unsigned char bytes[cache_line_size];
+    };
+
+    const unsigned buckets = E::buckets;
 
-        hist0[byte0(element0)]++;
-        hist1[byte1(element0)]++;
+    line buffers[buckets];
+    unsigned fill[buckets];
+    unsigned capacity[buckets];
 
-        hist0[byte0(element1)]++;
-        hist1[byte1(element1)]++;
+    for (unsigned value = 0; value < buckets; ++value)
+    {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(dst + (hist[value] + 1));
+        const unsigned line_offset = unsigned(address % cache_line_size) / sizeof(T);
+
+        fill[value] = 0;
+        capacity[value] = line_elements - line_offset;
+    }
+
+    const bool aligned = reinterpret_cast<uintptr_t>(dst) % sizeof(T) == 0;
+
+    for (T* i = src; i != src + count; ++i)
+    {
+        const auto key = bitwise_transform(*i);
+        const unsigned value = extract_byte(key);
+
+        if (!emit.emit(key, value, fill[value], hist[value]))
+            continue;
+
+        T* buffer = reinterpret_cast<T*>(buffers[value].bytes);
 
-        hist0[byte0(element2)]++;
-        hist1[byte1(element2)]++;
+        buffer[fill[value]++] = *i;
 
-        hist0[byte0(element3)]++;
-        hist1[byte1(element3)]++;
+        if (fill[value] != capacity[value])
+            continue;
+
+        T* to = dst + (hist[value] + 1);
+
+        if (fill[value] == line_elements && aligned)
+            radix_sort_write_line<non_temporal>(to, buffer);
+        else
+            std::memcpy(to, buffer, fill[value] * sizeof(T));
+
+        emit.written(value, hist[value] + 1, fill[value]);
+
+        hist[value] += fill[value];
+        fill[value] = 0;
+        capacity[value] = line_elements;
     }
 
-    for (; i != src_end; ++i)
+    for (unsigned value = 0; value < buckets; ++value)
     {
-        auto h = bitwise_transform(*i);
+        std::memcpy(dst + (hist[value] + 1), buffers[value].bytes, fill[value] * sizeof(T));
 
-        hist0[byte0(h)]++;
-        hist1[byte1(h)]++;
+        emit.written(value, hist[value] + 1, fill[value]);
+
+        hist[value] += fill[value];
     }
 
-    radix_sort_calculate_offset_table_16(hist0, hist1);
+#if RADIX_SORT_NON_TEMPORAL_STORES
+    if (non_temporal)
+        _mm_sfence();
+#endif
+}
 
-    COPY_WITH_REORDERING_UNROLLED(src, src_end, dst, hist0, byte0);
-    COPY_WITH_REORDERING_UNROLLED(dst, dst_end, src, hist1, byte1);
+template <bool non_temporal, typename T, typename F, typename E>
+inline void radix_sort_scatter_buffered(T* src, const unsigned count, T* dst, unsigned* hist,
+                                        F bitwise_transform, E extract_byte)
+{
+    radix_sort_emit_all emit;
+    radix_sort_scatter_buffered<non_temporal>(src, count, dst, hist, bitwise_transform, extract_byte, emit);
 }
 
-template <typename T, typename F>
-inline void radix_sort_32_impl(T* src, const unsigned count, T* dst, F bitwise_transform)
+// The direct scatter with an emit policy.
+template <typename T, typename F, typename E, typename S>
+void radix_sort_scatter_direct(T* src, const unsigned count, T* dst, unsigned* hist,
+                               F bitwise_transform, E extract_byte, S& emit)
 {
-    unsigned histograms[4][values_in_byte] = { 0 };
+    for (T* i = src; i != src + count; ++i)
+    {
+        const auto key = bitwise_transform(*i);
+        const unsigned value = extract_byte(key);
 
-    unsigned* hist0 = histograms[0];
-    unsigned* hist1 = histograms[1];
-    unsigned* hist2 = histograms[2];
-    unsigned* hist3 = histograms[3];
+        if (!emit.emit(key, value, 0, hist[value]))
+            continue;
 
-    T* src_end = src + count;
-    T* dst_end = dst + count;
+        dst[++hist[value]] = *i;
 
-    unsigned unroll_count = count >> 2;
+        emit.written(value, hist[value], 1);
+    }
+}
+
+template <typename T, typename F, typename E>
+inline void radix_sort_scatter_direct(T* src, const unsigned count, T* dst, unsigned* hist,
+                                      F bitwise_transform, E extract_byte, radix_sort_emit_all&)
+{
+    radix_sort_scatter_direct(src, count, dst, hist, bitwise_transform, extract_byte);
+}
 
-    T* i = src;
+// Buffering only pays off for small trivially copyable elements,
+// several of which share a cache line, and while the buffers of all
+// buckets fit in L2.
+template <typename T, typename E>
+struct radix_sort_can_buffer_scatter
+{
+    static const bool value = std::is_trivially_copyable<T>::value &&
+                              sizeof(T) <= 16 && cache_line_size % sizeof(T) == 0 &&
+                              E::buckets <= 2048;
+};
+
+template <typename T, typename F, typename E, typename S>
+inline void radix_sort_scatter_keys(std::true_type, T* src, const unsigned count, T* dst, unsigned* hist,
+                                    F bitwise_transform, E extract_byte, const unsigned total_count, S& emit)
+{
+    const bool buffered = RADIX_SORT_SCATTER == RADIX_SORT_SCATTER_BUFFERED ||
+                          (RADIX_SORT_SCATTER == RADIX_SORT_SCATTER_AUTO &&
+                           size_t(total_count) * sizeof(T) >= RADIX_SORT_BUFFERED_SCATTER_THRESHOLD);
+
+    if (buffered)
+        radix_sort_scatter_buffered<RADIX_SORT_NON_TEMPORAL_STORES != 0>(src, count, dst, hist,
+                                                                        bitwise_transform, extract_byte, emit);
+    else
+        radix_sort_scatter_direct(src, count, dst, hist, bitwise_transform, extract_byte, emit);
+}
 
-    for (; unroll_count; --unroll_count, i += 4)
-    {
-        auto element0 = bitwise_transform(*(i));
-        auto element1 = bitwise_transform(*(i+1));
-        auto element2 = bitwise_transform(*(i+2));
-        auto element3 = bitwise_transform(*(i+3));
+template <typename T, typename F, typename E, typename S>
+inline void radix_sort_scatter_keys(std::false_type, T* src, const unsigned count, T* dst, unsigned* hist,
+                                    F bitwise_transform, E extract_byte, unsigned, S& emit)
+{
+    radix_sort_scatter_direct(src, count, dst, hist, bitwise_transform, extract_byte, emit);
+}
 
-        hist0[byte0(element0)]++;
-        hist1[byte1(element0)]++;
-        hist2[byte2(element0)]++;
-        hist3[byte3(element0)]++;
+// Scatters a chunk of an array of total_count elements,
+// the strategy is picked by the size of the whole array.
+template <typename T, typename F, typename E, typename S>
+inline void radix_sort_scatter_chunk(T* src, const unsigned count, T* dst, unsigned* hist,
+                                     F bitwise_transform, E extract_byte, const unsigned total_count, S& emit)
+{
+    radix_sort_scatter_keys(std::integral_constant<bool, radix_sort_can_buffer_scatter<T, E>::value>(),
+                            src, count, dst, hist, bitwise_transform, extract_byte, total_count, emit);
+}
 
-        hist0[byte0(element1)]++;
-        hist1[byte1(element1)]++;
-        hist2[byte2(element1)]++;
-        hist3[byte3(element1)]++;
+template <typename T, typename F, typename E>
+inline void radix_sort_scatter_chunk(T* src, const unsigned count, T* dst, unsigned* hist,
+                                     F bitwise_transform, E extract_byte, const unsigned total_count)
+{
+    radix_sort_emit_all emit;
+    radix_sort_scatter_chunk(src, count, dst, hist, bitwise_transform, extract_byte, total_count, emit);
+}
 
-        hist0[byte0(element2)]++;
-        hist1[byte1(element2)]++;
-        hist2[byte2(element2)]++;
-        hist3[byte3(element2)]++;
+template <typename T, typename F, typename E>
+inline void radix_sort_scatter(T* src, const unsigned count, T* dst, unsigned* hist,
+                               F bitwise_transform, E extract_byte)
+{
+    radix_sort_scatter_chunk(src, count, dst, hist, bitwise_transform, extract_byte, count);
+}
 
-        hist0[byte0(element3)]++;
-        hist1[byte1(element3)]++;
-        hist2[byte2(element3)]++;
-        hist3[byte3(element3)]++;
-    }
+// Same as above, but every element also moves its payload values
+// from payload.data to payload.temp.
+template <typename T, typename F, typename E, typename P, typename... Ps>
+inline void radix_sort_scatter(T* src, const unsigned count, T* dst, unsigned* hist,
+                               F bitwise_transform, E extract_byte,
+                               radix_sort_payload<P> payload, radix_sort_payload<Ps>... rest)
+{
+    unsigned unroll_count = count >> 2;
+    unsigned i = 0;
 
-    for (; i != src_end; ++i)
+    for (; unroll_count; --unroll_count, i += 4)
     {
-        auto h = bitwise_transform(*i);
+        auto p0 = bitwise_transform(src[i]);
+        auto p1 = bitwise_transform(src[i+1]);
+        auto p2 = bitwise_transform(src[i+2]);
+        auto p3 = bitwise_transform(src[i+3]);
+
+        unsigned d0 = ++hist[extract_byte(p0)];
+        dst[d0] = src[i];
+        radix_sort_move_payload(i, d0, payload, rest...);
+
+        unsigned d1 = ++hist[extract_byte(p1)];
+        dst[d1] = src[i+1];
+        radix_sort_move_payload(i+1, d1, payload, rest...);
+
+        unsigned d2 = ++hist[extract_byte(p2)];
+        dst[d2] = src[i+2];
+        radix_sort_move_payload(i+2, d2, payload, rest...);
+
+        unsigned d3 = ++hist[extract_byte(p3)];
+        dst[d3] = src[i+3];
+        radix_sort_move_payload(i+3, d3, payload, rest...);
+    }
 
-        hist0[byte0(h)]++;
-        hist1[byte1(h)]++;
-        hist2[byte2(h)]++;
-        hist3[byte3(h)]++;
+    for (; i != count; ++i)
+    {
+        unsigned d = ++hist[extract_byte(bitwise_transform(src[i]))];
+        dst[d] = src[i];
+        radix_sort_move_payload(i, d, payload, rest...);
     }
+}
 
-    radix_sort_calculate_offset_table_32(hist0, hist1, hist2, hist3);
+// One reordering pass. Elements go from whichever of src/dst currently
+// holds them to the other one, in_dst tells which and is flipped.
+template <typename T, typename F, typename E, typename... P>
+inline void radix_sort_pass(T* src, const unsigned count, T* dst, unsigned* hist, bool& in_dst,
+                            F bitwise_transform, E extract_byte, radix_sort_payload<P>... payload)
+{
+    if (in_dst)
+        radix_sort_scatter(dst, count, src, hist, bitwise_transform, extract_byte, payload.swapped()...);
+    else
+        radix_sort_scatter(src, count, dst, hist, bitwise_transform, extract_byte, payload...);
 
-    COPY_WITH_REORDERING_UNROLLED(src, src_end, dst, hist0, byte0);
-    COPY_WITH_REORDERING_UNROLLED(dst, dst_end, src, hist1, byte1);
-    COPY_WITH_REORDERING_UNROLLED(src, src_end, dst, hist2, byte2);
-    COPY_WITH_REORDERING_UNROLLED(dst, dst_end, src, hist3, byte3);
+    in_dst = !in_dst;
 }
 
-template <typename T, typename F>
-inline void radix_sort_64_impl(T* src, unsigned count, T* dst, F bitwise_transform)
+inline void radix_sort_copy_payload(unsigned)
 {
-    unsigned histograms[8][values_in_byte] = { 0 };
+}
 
-    unsigned* hist0 = histograms[0];
-    unsigned* hist1 = histograms[1];
-    unsigned* hist2 = histograms[2];
-    unsigned* hist3 = histograms[3];
-    unsigned* hist4 = histograms[4];
-    unsigned* hist5 = histograms[5];
-    unsigned* hist6 = histograms[6];
-    unsigned* hist7 = histograms[7];
+template <typename P, typename... Ps>
+inline void radix_sort_copy_payload(const unsigned count, radix_sort_payload<P> payload,
+                                    radix_sort_payload<Ps>... rest)
+{
+    std::copy(payload.temp, payload.temp + count, payload.data);
+    radix_sort_copy_payload(count, rest...);
+}
 
-    T* src_end = src + count;
-    T* dst_end = dst + count;
+// Called after the last pass: if an odd number of passes was made,
+// the result is in dst (and in payload.temp) and is copied back.
+template <typename T, typename... P>
+inline void radix_sort_finish(T* src, const unsigned count, T* dst, const bool in_dst,
+                              radix_sort_payload<P>... payload)
+{
+    if (!in_dst)
+        return;
 
-    unsigned unroll_count = count >> 2;
+    std::copy(dst, dst + count, src);
+    radix_sort_copy_payload(count, payload...);
+}
+
+// Replaces every histogram with a table of offsets for reordering:
+// each bucket gets the index of its first element minus one.
+// Buckets start at first_offset, elements before it are placed elsewhere.
+template <unsigned histogram_count, unsigned buckets>
+inline void radix_sort_calculate_offset_table(unsigned* histograms, const unsigned first_offset = 0)
+{
+    static_assert(buckets % 4 == 0, "buckets are processed four at a time");
 
-    T* i = src;
+    unsigned offsets[histogram_count];
 
-    for (; unroll_count; --unroll_count, i += 4)
+    for (unsigned h = 0; h < histogram_count; ++h)
+        offsets[h] = first_offset;
+
+    for (unsigned i = 0; i < buckets; i += 4)
     {
-        auto element0 = bitwise_transform(*i);
-        auto element1 = bitwise_transform(*(i + 1));
-        auto element2 = bitwise_transform(*(i + 2));
-        auto element3 = bitwise_transform(*(i + 3));
+        for (unsigned h = 0; h < histogram_count; ++h)
+        {
+            unsigned* hist = histograms + h * buckets;
+
+            unsigned temp_offset = hist[i] + offsets[h];
+            hist[i] = offsets[h] - 1;
+            offsets[h] = temp_offset;
+
+            temp_offset = hist[i+1] + offsets[h];
+            hist[i+1] = offsets[h] - 1;
+            offsets[h] = temp_offset;
+
+            temp_offset = hist[i+2] + offsets[h];
+            hist[i+2] = offsets[h] - 1;
+            offsets[h] = temp_offset;
+
+            temp_offset = hist[i+3] + offsets[h];
+            hist[i+3] = offsets[h] - 1;
+            offsets[h] = temp_offset;
+        }
+    }
+}
+
+// Zeroed histograms for all passes. Small ones live on the stack,
+// the ones of 16 bit digits (256 KB per pass) on the heap.
+template <unsigned size, bool on_stack = (size <= (1U << 14))>
+struct radix_sort_histograms
+{
+    unsigned data[size];
+
+    radix_sort_histograms() : data() { }
 
-        hist0[byte0(element0)]++;
-        hist1[byte1(element0)]++;
-        hist2[byte2(element0)]++;
-        hist3[byte3(element0)]++;
-        hist4[byte4(element0)]++;
-        hist5[byte5(element0)]++;
-        hist6[byte6(element0)]++;
-        hist7[byte7(element0)]++;
-
-        hist0[byte0(element1)]++;
-        hist1[byte1(element1)]++;
-        hist2[byte2(element1)]++;
-        hist3[byte3(element1)]++;
-        hist4[byte4(element1)]++;
-        hist5[byte5(element1)]++;
-        hist6[byte6(element1)]++;
-        hist7[byte7(element1)]++;
-
-        hist0[byte0(element2)]++;
-        hist1[byte1(element2)]++;
-        hist2[byte2(element2)]++;
-        hist3[byte3(element2)]++;
-        hist4[byte4(element2)]++;
-        hist5[byte5(element2)]++;
-        hist6[byte6(element2)]++;
-        hist7[byte7(element2)]++;
-
-        hist0[byte0(element3)]++;
-        hist1[byte1(element3)]++;
-        hist2[byte2(element3)]++;
-        hist3[byte3(element3)]++;
-        hist4[byte4(element3)]++;
-        hist5[byte5(element3)]++;
-        hist6[byte6(element3)]++;
-        hist7[byte7(element3)]++;
+    unsigned* get()
+    {
+        return data;
     }
+};
 
-    for (; i != src_end; ++i)
+template <unsigned size>
+struct radix_sort_histograms<size, false>
+{
+    std::vector<unsigned> data;
+
+    radix_sort_histograms() : data(size) { }
+
+    unsigned* get()
     {
-        auto h = bitwise_transform(*i);
+        return data.data();
+    }
+};
+
+// Scratch memory for repeated sorts: a buffer for the elements (and payload)
+// being reordered and the histograms. The buffer is 64 byte aligned and only
+// grows, so sorts of up to the largest size seen so far don't allocate and
+// find their pages already faulted in. On Linux buffers of 2 MB and more are
+// mapped with huge pages if some are reserved (MAP_HUGETLB), otherwise
+// marked for transparent huge pages. Not thread safe, one per thread.
+class radix_sort_workspace
+{
+public:
 
-        hist0[byte0(h)]++;
-        hist1[byte1(h)]++;
-        hist2[byte2(h)]++;
-        hist3[byte3(h)]++;
-        hist4[byte4(h)]++;
-        hist5[byte5(h)]++;
-        hist6[byte6(h)]++;
-        hist7[byte7(h)]++;
+    static const size_t alignment = 64;
+
+    static size_t aligned_size(const size_t bytes)
+    {
+        return (bytes + alignment - 1) & ~(alignment - 1);
     }
 
-    radix_sort_calculate_offset_table_64(hist0, hist1, hist2, hist3, hist4, hist5, hist6, hist7);
+    radix_sort_workspace() : memory(nullptr), allocation(nullptr), size(0), mapped(false) { }
 
-    COPY_WITH_REORDERING_UNROLLED(src, src_end, dst, hist0, byte0);
-    COPY_WITH_REORDERING_UNROLLED(dst, dst_end, src, hist1, byte1);
-    COPY_WITH_REORDERING_UNROLLED(src, src_end, dst, hist2, byte2);
-    COPY_WITH_REORDERING_UNROLLED(dst, dst_end, src, hist3, byte3);
+    explicit radix_sort_workspace(const size_t bytes) : radix_sort_workspace()
+    {
+        get(bytes);
+    }
 
-    COPY_WITH_REORDERING_UNROLLED(src, src_end, dst, hist4, byte4);
-    COPY_WITH_REORDERING_UNROLLED(dst, dst_end, src, hist5, byte5);
-    COPY_WITH_REORDERING_UNROLLED(src, src_end, dst, hist6, byte6);
-    COPY_WITH_REORDERING_UNROLLED(dst, dst_end, src, hist7, byte7);
+    ~radix_sort_workspace()
+    {
+        release();
+    }
 
-}
+    radix_sort_workspace(const radix_sort_workspace&) = delete;
+    radix_sort_workspace& operator=(const radix_sort_workspace&) = delete;
 
-#undef COPY_WITH_REORDERING_UNROLLED
-#undef byte0
-#undef byte1
-#undef byte2
-#undef byte3
-#undef byte4
-#undef byte5
-#undef byte6
-#undef byte7
-
-void radix_sort(uint8_t * src, const unsigned count)
-{    
-    unsigned histogram[values_in_byte] = { 0 };
+    size_t capacity() const
+    {
+        return size;
+    }
 
-    for(unsigned i = 0; i < count; ++i)
-        ++histogram[src[i]];
+    // At least bytes of scratch memory. The contents are lost when it grows.
+    char* get(const size_t bytes)
+    {
+        if (bytes > size)
+            grow(bytes > size + size / 2 ? bytes : size + size / 2);
 
-    unsigned write_index = 0;
+        return memory;
+    }
 
-    for(unsigned value = 0; value < values_in_byte; ++value)
+    // The elements are assigned to without being constructed.
+    template <typename T>
+    T* buffer(const size_t count)
     {
-        const unsigned element_count = histogram[value];
+        static_assert(std::is_trivially_copyable<T>::value, "workspace buffers only hold trivially copyable types");
 
-        for (unsigned i = 0; i < element_count; ++i, ++write_index)
-            src[write_index] = uint8_t(value);
+        return reinterpret_cast<T*>(get(count * sizeof(T)));
     }
-}
 
-void radix_sort(int8_t * src, unsigned count)
+    // Zeroed histograms of count buckets in total.
+    unsigned* histograms(const size_t count)
+    {
+        histogram_storage.assign(count, 0);
+        return histogram_storage.data();
+    }
+
+private:
+
+    char* memory;
+    void* allocation;
+    size_t size;
+    bool mapped;
+
+    std::vector<unsigned> histogram_storage;
+
+    void grow(size_t bytes)
+    {
+        release();
+
+#ifdef __linux__
+        const size_t huge_page = size_t(1) << 21;
+
+        bytes = aligned_size(bytes);
+
+        void* mapping = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+        if (bytes >= huge_page)
+        {
+            bytes = (bytes + huge_page - 1) & ~(huge_page - 1);
+            mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        }
+#endif
+
+        if (mapping == MAP_FAILED)
+        {
+            mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+#ifdef MADV_HUGEPAGE
+            if (mapping != MAP_FAILED && bytes >= huge_page)
+                madvise(mapping, bytes, MADV_HUGEPAGE);
+#endif
+        }
+
+        if (mapping != MAP_FAILED)
+        {
+            allocation = mapping;
+            memory = static_cast<char*>(mapping);
+            size = bytes;
+            mapped = true;
+            return;
+        }
+#endif
+
+        allocation = std::malloc(bytes + alignment);
+
+        if (!allocation)
+            throw std::bad_alloc();
+
+        memory = reinterpret_cast<char*>(aligned_size(reinterpret_cast<uintptr_t>(allocation)));
+        size = bytes;
+        mapped = false;
+    }
+
+    void release()
+    {
+#ifdef __linux__
+        if (mapped)
+            munmap(allocation, size);
+#endif
+
+        if (!mapped)
+            std::free(allocation);
+
+        memory = nullptr;
+        allocation = nullptr;
+        size = 0;
+        mapped = false;
+    }
+};
+
+// Number of passes of a radix_bits wide digit over keys of key_bytes bytes.
+template <unsigned radix_bits, unsigned key_bytes>
+struct radix_sort_pass_count
 {
-    unsigned histogram[values_in_byte] = { 0 };
+    static const unsigned value = (key_bytes * CHAR_BIT + radix_bits - 1) / radix_bits;
+};
+
+// Instrumentation of the LSD sort. An observer gets called at the start
+// and the end of every phase, with the bytes the phase moved, and with
+// the histogram of every digit before the offset table is built.
+// radix_sort_null_observer does nothing and compiles away.
+enum class radix_sort_phase
+{
+    histogram,
+    offset_table,
+    scatter,
+    merge,
+    copy_back
+};
+
+struct radix_sort_null_observer
+{
+    void phase_begin(radix_sort_phase, unsigned) { }
 
-    for(unsigned i = 0; i < count; ++i)
-        ++histogram[int32_t(src[i]) + int32_t(128)];
+    void phase_end(radix_sort_phase, unsigned, size_t) { }
 
-    unsigned write_index = 0;
+    void digit_histogram(unsigned, const unsigned*, unsigned, bool) { }
+};
+
+template <typename T>
+struct radix_sort_is_payload : std::false_type { };
+
+template <typename P>
+struct radix_sort_is_payload<radix_sort_payload<P> > : std::true_type { };
+
+// Bytes of one element together with its payload.
+template <typename T, typename... P>
+struct radix_sort_element_size
+{
+    static const size_t value = sizeof(T);
+};
+
+template <typename T, typename P, typename... Ps>
+struct radix_sort_element_size<T, P, Ps...>
+{
+    static const size_t value = sizeof(P) + radix_sort_element_size<T, Ps...>::value;
+};
+
+struct radix_sort_pass_stats
+{
+    unsigned pass;
+    bool skipped;
+    unsigned non_empty_buckets;
+    unsigned max_bucket_size;
+    double scatter_seconds;
+    size_t bytes_moved;
+};
+
+// Observer which collects per-phase wall time, digit statistics
+// and bytes moved, to be read after the sort. Use a fresh one for every sort.
+struct radix_sort_stats
+{
+    double histogram_seconds = 0;
+    double offset_table_seconds = 0;
+    double merge_seconds = 0;
+    double copy_back_seconds = 0;
+    size_t bytes_moved = 0;
+    std::vector<radix_sort_pass_stats> passes;
+
+    std::chrono::steady_clock::time_point phase_start;
 
-    for(int32_t value = 0; value < values_in_byte; ++value)
+    void phase_begin(radix_sort_phase, unsigned)
     {
-        const unsigned element_count = histogram[value];
+        phase_start = std::chrono::steady_clock::now();
+    }
 
-        const int8_t write_value = int8_t(value - int32_t(128));
+    void phase_end(radix_sort_phase phase, unsigned pass, size_t bytes)
+    {
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - phase_start).count();
+
+        bytes_moved += bytes;
+
+        switch (phase)
+        {
+            case radix_sort_phase::histogram: histogram_seconds += seconds; break;
+            case radix_sort_phase::offset_table: offset_table_seconds += seconds; break;
+            case radix_sort_phase::merge: merge_seconds += seconds; break;
+            case radix_sort_phase::copy_back: copy_back_seconds += seconds; break;
+
+            case radix_sort_phase::scatter:
+                for (auto& stats : passes)
+                {
+                    if (stats.pass == pass)
+                    {
+                        stats.scatter_seconds += seconds;
+                        stats.bytes_moved += bytes;
+                    }
+                }
+                break;
+        }
+    }
 
-        for (unsigned i = 0; i < element_count; ++i, ++write_index)
-            src[write_index] = write_value;
+    void digit_histogram(unsigned pass, const unsigned* histogram, unsigned buckets, bool skipped)
+    {
+        radix_sort_pass_stats stats = { pass, skipped, 0, 0, 0, 0 };
+
+        for (unsigned bucket = 0; bucket < buckets; ++bucket)
+        {
+            stats.non_empty_buckets += histogram[bucket] != 0;
+            stats.max_bucket_size = std::max(stats.max_bucket_size, histogram[bucket]);
+        }
+
+        passes.push_back(stats);
     }
-}
+};
 
-void radix_sort(uint16_t* src, unsigned count, uint16_t* temp)
+// The second set of histograms of the split counting lives on the stack.
+template <unsigned histogram_size>
+struct radix_sort_can_split_histograms
+{
+    static const bool value = histogram_size <= (1U << 14);
+};
+
+// Builds the histograms of all digits in a single pass over the input and
+// returns the number of places where a key is less than the one before it,
+// which is 0 for sorted input and the number of natural runs minus one
+// otherwise. With split, odd elements count into a second set of histograms which is
+// added up at the end: when neighbouring elements share a digit (sorted
+// input, constant high bytes, few distinct keys) every increment would
+// otherwise wait for the store of the previous one to the same counter.
+template <bool split, unsigned radix_bits, typename T, typename F>
+unsigned radix_sort_count_digits(const T* src, const unsigned count, unsigned* histograms, F bitwise_transform)
 {
-    auto identity = [](uint16_t v) -> uint16_t
+    typedef radix_sort_digit<radix_bits> digit;
+
+    const unsigned buckets = digit::buckets;
+    const unsigned passes = radix_sort_pass_count<radix_bits, sizeof(bitwise_transform(*src))>::value;
+    const unsigned histogram_size = passes * buckets;
+
+    static_assert(!split || radix_sort_can_split_histograms<histogram_size>::value,
+                  "split histograms must fit on the stack");
+
+    unsigned odd_storage[split ? histogram_size : 1];
+    unsigned* odd_histograms = histograms;
+
+    if (split)
     {
-        return v;
-    };
+        std::fill(odd_storage, odd_storage + histogram_size, 0U);
+        odd_histograms = odd_storage;
+    }
 
-    radix_sort_16_impl(src, count, temp, identity);
-}
+    if (!count)
+        return 0;
 
-void radix_sort(int16_t* src, unsigned count, int16_t* temp)
-{
-    auto flip_sign = [](int16_t v) -> uint16_t
+    const T* src_end = src + count;
+
+    unsigned unroll_count = count >> 2;
+
+    const T* i = src;
+
+    auto previous = bitwise_transform(*src);
+    unsigned descents = 0;
+
+    for (; unroll_count; --unroll_count, i += 4)
     {
-        return  *reinterpret_cast<uint16_t*>(&v) ^ (uint16_t(1) << 15);
-    };
+        auto element0 = bitwise_transform(*i);
+        auto element1 = bitwise_transform(*(i + 1));
+        auto element2 = bitwise_transform(*(i + 2));
+        auto element3 = bitwise_transform(*(i + 3));
 
-    radix_sort_16_impl(src, count, temp, flip_sign);
-}
+        descents += unsigned(element0 < previous) + unsigned(element1 < element0)
+                  + unsigned(element2 < element1) + unsigned(element3 < element2);
 
-void radix_sort(uint32_t * src, unsigned count, uint32_t* temp)
-{
-    auto identity = [](uint32_t v) -> uint32_t
+        previous = element3;
+
+        for (unsigned pass = 0; pass < passes; ++pass)
+        {
+            const digit d(pass * radix_bits);
+            unsigned* hist = histograms + pass * buckets;
+            unsigned* odd_hist = odd_histograms + pass * buckets;
+
+            hist[d(element0)]++;
+            odd_hist[d(element1)]++;
+            hist[d(element2)]++;
+            odd_hist[d(element3)]++;
+        }
+    }
+
+    for (; i != src_end; ++i)
     {
-        return v;
-    };
+        auto h = bitwise_transform(*i);
+
+        descents += unsigned(h < previous);
+        previous = h;
 
-    radix_sort_32_impl(src, count, temp, identity);
+        for (unsigned pass = 0; pass < passes; ++pass)
+            histograms[pass * buckets + digit(pass * radix_bits)(h)]++;
+    }
+
+    if (split)
+        for (unsigned bucket = 0; bucket < histogram_size; ++bucket)
+            histograms[bucket] += odd_storage[bucket];
+
+    return descents;
 }
 
-void radix_sort(int32_t * src, unsigned count, int32_t* temp)
+// Stable bottom-up merge of the natural runs of src, ping-ponging between
+// src and dst like the scatter passes. Returns true if the result is in dst.
+template <typename T, typename F>
+bool radix_sort_merge_natural_runs(T* src, const unsigned count, T* dst, F bitwise_transform,
+                                   const unsigned run_count)
 {
-    auto flip_sign = [](int32_t v) -> uint32_t
+    std::vector<unsigned> run_starts;
+    run_starts.reserve(run_count + 1);
+    run_starts.push_back(0);
+
+    for (unsigned i = 1; i < count; ++i)
+        if (bitwise_transform(src[i]) < bitwise_transform(src[i - 1]))
+            run_starts.push_back(i);
+
+    run_starts.push_back(count);
+
+    auto less = [&bitwise_transform](const T& a, const T& b)
     {
-        return  *reinterpret_cast<uint32_t*>(&v) ^ (uint32_t(1) << 31);
+        return bitwise_transform(a) < bitwise_transform(b);
     };
 
-    radix_sort_32_impl(src, count, temp, flip_sign);
-}
+    bool in_dst = false;
 
-void radix_sort(uint64_t* src, unsigned count, uint64_t* temp)
-{
-    auto identity = [](uint64_t v) -> uint64_t
+    std::vector<unsigned> merged_starts;
+
+    while (run_starts.size() > 2)
     {
-        return v;
-    };
+        const size_t runs = run_starts.size() - 1;
+
+        T* from = in_dst ? dst : src;
+        T* to = in_dst ? src : dst;
+
+        merged_starts.clear();
+
+        for (size_t run = 0; run < runs; run += 2)
+        {
+            const unsigned begin = run_starts[run];
+            const unsigned middle = run_starts[run + 1];
+            const unsigned end = run + 2 <= runs ? run_starts[run + 2] : middle;
+
+            std::merge(from + begin, from + middle, from + middle, from + end, to + begin, less);
+
+            merged_starts.push_back(begin);
+        }
+
+        merged_starts.push_back(count);
+        run_starts.swap(merged_starts);
+
+        in_dst = !in_dst;
+    }
 
-    radix_sort_64_impl(src, count, temp, identity);
+    return in_dst;
 }
 
-void radix_sort(int64_t * src, unsigned count, int64_t* temp)
+// Below this many elements zeroing a second set of histograms costs more than it saves.
+const unsigned radix_sort_split_histograms_threshold = 1U << 12;
+
+// Number of buckets in the histograms of all digits of an LSD sort.
+template <unsigned radix_bits, unsigned key_bytes>
+struct radix_sort_histogram_size
 {
-    auto flip_sign = [](int64_t v) -> uint64_t
+    static const unsigned value = radix_sort_pass_count<radix_bits, key_bytes>::value
+                                  * radix_sort_digit<radix_bits>::buckets;
+};
+
+// The reordering part of radix_sort_lsd_with_histograms, for histograms of
+// all digits and the number of descents already counted over src.
+template <unsigned radix_bits, typename T, typename F, typename O, typename... P>
+void radix_sort_lsd_counted(T* src, const unsigned count, T* dst, F bitwise_transform, O& observer,
+                            unsigned* histograms, const unsigned descents, radix_sort_payload<P>... payload)
+{
+    typedef radix_sort_digit<radix_bits> digit;
+
+    const unsigned buckets = digit::buckets;
+    const unsigned passes = radix_sort_pass_count<radix_bits, sizeof(bitwise_transform(*src))>::value;
+    const size_t pass_bytes = size_t(count) * radix_sort_element_size<T, P...>::value;
+
+    // Input that is already sorted stays as it is.
+    if (!count || !descents)
+        return;
+
+    // A digit that is the same in every element doesn't change the order,
+    // its pass is skipped.
+    const auto first = bitwise_transform(*src);
+
+    bool skip[passes];
+
+    unsigned scatter_passes = 0;
+
+    for (unsigned pass = 0; pass < passes; ++pass)
     {
-        return  *reinterpret_cast<uint64_t*>(&v) ^ (uint64_t(1) << 63);
-    };
+        skip[pass] = histograms[pass * buckets + digit(pass * radix_bits)(first)] == count;
+        scatter_passes += !skip[pass];
+    }
 
-    radix_sort_64_impl(src, count, temp, flip_sign);
-}
+    // A few sorted runs are merged instead. A merge pass costs about as
+    // much as two scatter passes. Payload isn't moved by the merge.
+    unsigned merge_passes = 0;
 
-void radix_sort(float* src, unsigned count, float* temp)
-{
-    auto flip = [](float v) -> uint32_t
+    while ((1ULL << merge_passes) < uint64_t(descents) + 1)
+        ++merge_passes;
+
+    if (sizeof...(P) == 0 && 2 * merge_passes < scatter_passes)
     {
-        // if floats are guaranteed to be >= 0,
-        // you can do this(will be a bit faster):
-        // return *reinterpret_cast<uint32_t*>(&v);
-        // otherwise:
-        uint32_t as_uint = *reinterpret_cast<uint32_t*>(&v);
-        uint32_t mask = -int32_t(as_uint >> 31) | (uint32_t(1) << 31);
-        return as_uint ^ mask;
-    };
+        observer.phase_begin(radix_sort_phase::merge, 0);
 
-    radix_sort_32_impl(src, count, temp, flip);
-}
+        const bool merged_in_dst = radix_sort_merge_natural_runs(src, count, dst, bitwise_transform, descents + 1);
 
-template <typename T>
-void radix_sort(T* src, const unsigned count)
-{
-    T * temp = new T[count];
-    radix_sort(src, count, temp);
-    delete[] temp;
+        observer.phase_end(radix_sort_phase::merge, 0, merge_passes * pass_bytes);
+
+        observer.phase_begin(radix_sort_phase::copy_back, 0);
+
+        radix_sort_finish(src, count, dst, merged_in_dst);
+
+        observer.phase_end(radix_sort_phase::copy_back, 0, merged_in_dst ? pass_bytes : 0);
+        return;
+    }
+
+    for (unsigned pass = 0; pass < passes; ++pass)
+        observer.digit_histogram(pass, histograms + pass * buckets, buckets, skip[pass]);
+
+    observer.phase_begin(radix_sort_phase::offset_table, 0);
+
+    radix_sort_calculate_offset_table<passes, buckets>(histograms);
+
+    observer.phase_end(radix_sort_phase::offset_table, 0, 0);
+
+    bool in_dst = false;
+
+    for (unsigned pass = 0; pass < passes; ++pass)
+    {
+        if (skip[pass])
+            continue;
+
+        observer.phase_begin(radix_sort_phase::scatter, pass);
+
+        radix_sort_pass(src, count, dst, histograms + pass * buckets, in_dst,
+                        bitwise_transform, digit(pass * radix_bits), payload...);
+
+        observer.phase_end(radix_sort_phase::scatter, pass, pass_bytes);
+    }
+
+    observer.phase_begin(radix_sort_phase::copy_back, 0);
+
+    radix_sort_finish(src, count, dst, in_dst, payload...);
+
+    observer.phase_end(radix_sort_phase::copy_back, 0, in_dst ? pass_bytes : 0);
+}
+
+// LSD radix sort, one pass per digit of radix_bits bits.
+// Histograms of all digits are built in a single pass over the input,
+// then every digit which isn't the same in all elements gets a reordering pass.
+// Sorted input is left as it is right after the counting pass, input made
+// of a few sorted runs is merged instead of scattered.
+// histograms must be zeroed, radix_sort_histogram_size buckets long.
+template <unsigned radix_bits, typename T, typename F, typename O, typename... P>
+void radix_sort_lsd_with_histograms(T* src, const unsigned count, T* dst, F bitwise_transform, O& observer,
+                                    unsigned* histograms, radix_sort_payload<P>... payload)
+{
+    static_assert(radix_bits >= 2 && radix_bits <= 16, "digit width must be from 2 to 16 bits");
+
+    const unsigned buckets = radix_sort_digit<radix_bits>::buckets;
+    const unsigned passes = radix_sort_pass_count<radix_bits, sizeof(bitwise_transform(*src))>::value;
+
+    if (!count)
+        return;
+
+    observer.phase_begin(radix_sort_phase::histogram, 0);
+
+    const unsigned descents = count >= radix_sort_split_histograms_threshold
+        ? radix_sort_count_digits<radix_sort_can_split_histograms<passes * buckets>::value, radix_bits>(
+              src, count, histograms, bitwise_transform)
+        : radix_sort_count_digits<false, radix_bits>(src, count, histograms, bitwise_transform);
+
+    observer.phase_end(radix_sort_phase::histogram, 0, 0);
+
+    radix_sort_lsd_counted<radix_bits>(src, count, dst, bitwise_transform, observer, histograms, descents,
+                                       payload...);
+}
+
+template <unsigned radix_bits, typename T, typename F, typename O, typename... P>
+inline typename std::enable_if<!radix_sort_is_payload<O>::value>::type
+radix_sort_lsd_impl(T* src, const unsigned count, T* dst, F bitwise_transform, O& observer,
+                    radix_sort_payload<P>... payload)
+{
+    radix_sort_histograms<radix_sort_histogram_size<radix_bits, sizeof(bitwise_transform(*src))>::value> storage;
+
+    radix_sort_lsd_with_histograms<radix_bits>(src, count, dst, bitwise_transform, observer, storage.get(),
+                                               payload...);
+}
+
+template <unsigned radix_bits, typename T, typename F, typename... P>
+inline void radix_sort_lsd_impl(T* src, const unsigned count, T* dst, F bitwise_transform,
+                                radix_sort_payload<P>... payload)
+{
+    radix_sort_null_observer observer;
+    radix_sort_lsd_impl<radix_bits>(src, count, dst, bitwise_transform, observer, payload...);
+}
+
+// Run-length compaction of sorted src: one element of every run of equal
+// keys is moved to the front, counts (if not null) gets the run lengths.
+// Returns the number of runs.
+template <typename T, typename F>
+unsigned radix_sort_unique_sorted(T* src, const unsigned count, F bitwise_transform, unsigned* counts)
+{
+    if (!count)
+        return 0;
+
+    unsigned last = 0;
+
+    if (counts)
+        counts[0] = 1;
+
+    for (unsigned i = 1; i < count; ++i)
+    {
+        if (bitwise_transform(src[i]) == bitwise_transform(src[last]))
+        {
+            if (counts)
+                counts[last]++;
+        }
+        else
+        {
+            src[++last] = src[i];
+
+            if (counts)
+                counts[last] = 1;
+        }
+    }
+
+    return last + 1;
+}
+
+// Last reordering pass of radix_sort_unique. In the pass of the highest
+// digit the elements of a bucket arrive in sorted order, so an element equal
+// to the last one written to its bucket is dropped and only counted.
+// last_keys of every bucket start with a key of another bucket, which no key
+// of this one equals.
+template <typename K, typename E>
+inline std::vector<K> radix_sort_unique_last_keys(E extract_digit)
+{
+    std::vector<K> last_keys(E::buckets);
+
+    for (unsigned d = 0; d < E::buckets; ++d)
+        last_keys[d] = K(K(d ^ 1) << extract_digit.shift);
+
+    return last_keys;
+}
+
+// Emit policy of that pass. Counts of the elements waiting in the buffer
+// of a bucket are kept next to it and written out with them.
+template <bool with_counts, typename T, typename K>
+class radix_sort_emit_unique
+{
+public:
+
+    template <typename E>
+    radix_sort_emit_unique(E extract_digit, unsigned* counts)
+        : last_keys(radix_sort_unique_last_keys<K>(extract_digit)), counts(counts),
+          count_buffers(with_counts ? E::buckets * line_elements : 0) { }
+
+    bool emit(const K& key, const unsigned value, const unsigned pending, const unsigned written)
+    {
+        if (last_keys[value] == key)
+        {
+            if (with_counts)
+            {
+                if (pending)
+                    count_buffers[value * line_elements + pending - 1]++;
+                else
+                    counts[written]++;
+            }
+
+            return false;
+        }
+
+        last_keys[value] = key;
+
+        if (with_counts)
+            count_buffers[value * line_elements + pending] = 1;
+
+        return true;
+    }
+
+    void written(const unsigned value, const unsigned first, const unsigned count)
+    {
+        if (with_counts)
+            std::memcpy(counts + first, &count_buffers[value * line_elements], count * sizeof(unsigned));
+    }
+
+private:
+
+    // One for elements too large to share a cache line, which are never buffered.
+    static const unsigned line_elements = sizeof(T) < cache_line_size ? cache_line_size / sizeof(T) : 1;
+
+    std::vector<K> last_keys;
+    unsigned* counts;
+    std::vector<unsigned> count_buffers;
+};
+
+template <bool with_counts, typename T, typename F, typename E>
+inline void radix_sort_scatter_unique(T* src, const unsigned count, T* dst, unsigned* hist, unsigned* counts,
+                                      F bitwise_transform, E extract_digit)
+{
+    radix_sort_emit_unique<with_counts, T, decltype(bitwise_transform(*src))> emit(extract_digit, counts);
+
+    radix_sort_scatter_chunk(src, count, dst, hist, bitwise_transform, extract_digit, count, emit);
+}
+
+// LSD radix sort that leaves one element of every run of equal keys,
+// packed at the front of src; returns how many. All passes but the last
+// are the usual ones, the last one drops repeats as it scatters. Packing
+// the buckets together moves only the distinct elements and replaces the
+// copy back when the result is in dst. counts, if not null, gets the
+// number of repeats of every distinct key and must have room for count.
+template <unsigned radix_bits, typename T, typename F>
+unsigned radix_sort_unique_impl(T* src, const unsigned count, T* dst, F bitwise_transform, unsigned* counts)
+{
+    typedef radix_sort_digit<radix_bits> digit;
+
+    const unsigned buckets = digit::buckets;
+    const unsigned passes = radix_sort_pass_count<radix_bits, sizeof(bitwise_transform(*src))>::value;
+
+    if (!count)
+        return 0;
+
+    radix_sort_histograms<radix_sort_histogram_size<radix_bits, sizeof(bitwise_transform(*src))>::value> storage;
+
+    unsigned* histograms = storage.get();
+
+    const unsigned descents = count >= radix_sort_split_histograms_threshold
+        ? radix_sort_count_digits<radix_sort_can_split_histograms<passes * buckets>::value, radix_bits>(
+              src, count, histograms, bitwise_transform)
+        : radix_sort_count_digits<false, radix_bits>(src, count, histograms, bitwise_transform);
+
+    if (!descents)
+        return radix_sort_unique_sorted(src, count, bitwise_transform, counts);
+
+    const auto first = bitwise_transform(*src);
+
+    bool skip[passes];
+
+    unsigned last_pass = 0;
+
+    for (unsigned pass = 0; pass < passes; ++pass)
+    {
+        skip[pass] = histograms[pass * buckets + digit(pass * radix_bits)(first)] == count;
+
+        if (!skip[pass])
+            last_pass = pass;
+    }
+
+    radix_sort_calculate_offset_table<passes, buckets>(histograms);
+
+    bool in_dst = false;
+
+    for (unsigned pass = 0; pass < last_pass; ++pass)
+        if (!skip[pass])
+            radix_sort_pass(src, count, dst, histograms + pass * buckets, in_dst,
+                            bitwise_transform, digit(pass * radix_bits));
+
+    unsigned* hist = histograms + last_pass * buckets;
+
+    const std::vector<unsigned> empty(hist, hist + buckets);
+
+    T* from = in_dst ? dst : src;
+    T* to = in_dst ? src : dst;
+
+    if (counts)
+        radix_sort_scatter_unique<true>(from, count, to, hist, counts, bitwise_transform, digit(last_pass * radix_bits));
+    else
+        radix_sort_scatter_unique<false>(from, count, to, hist, counts, bitwise_transform, digit(last_pass * radix_bits));
+
+    unsigned distinct = 0;
+
+    for (unsigned bucket = 0; bucket < buckets; ++bucket)
+    {
+        const unsigned begin = empty[bucket] + 1;
+        const unsigned end = hist[bucket] + 1;
+
+        if (to != src || begin != distinct)
+        {
+            std::copy(to + begin, to + end, src + distinct);
+
+            if (counts)
+                std::copy(counts + begin, counts + end, counts + distinct);
+        }
+
+        distinct += end - begin;
+    }
+
+    return distinct;
+}
+
+// The impl functions take an optional observer before the payload.
+template <unsigned radix_bits = RADIX_SORT_DIGIT_BITS, typename T, typename F, typename O, typename... P>
+inline typename std::enable_if<!radix_sort_is_payload<O>::value>::type
+radix_sort_16_impl(T* src, unsigned count, T* dst, F bitwise_transform, O& observer,
+                   radix_sort_payload<P>... payload)
+{
+    static_assert(sizeof(bitwise_transform(*src)) == 2, "16 bit keys expected");
+
+    radix_sort_lsd_impl<radix_bits>(src, count, dst, bitwise_transform, observer, payload...);
+}
+
+template <unsigned radix_bits = RADIX_SORT_DIGIT_BITS, typename T, typename F, typename... P>
+inline void radix_sort_16_impl(T* src, unsigned count, T* dst, F bitwise_transform,
+                               radix_sort_payload<P>... payload)
+{
+    radix_sort_null_observer observer;
+    radix_sort_16_impl<radix_bits>(src, count, dst, bitwise_transform, observer, payload...);
+}
+
+template <unsigned radix_bits = RADIX_SORT_DIGIT_BITS, typename T, typename F, typename O, typename... P>
+inline typename std::enable_if<!radix_sort_is_payload<O>::value>::type
+radix_sort_32_impl(T* src, unsigned count, T* dst, F bitwise_transform, O& observer,
+                   radix_sort_payload<P>... payload)
+{
+    static_assert(sizeof(bitwise_transform(*src)) == 4, "32 bit keys expected");
+
+    radix_sort_lsd_impl<radix_bits>(src, count, dst, bitwise_transform, observer, payload...);
+}
+
+template <unsigned radix_bits = RADIX_SORT_DIGIT_BITS, typename T, typename F, typename... P>
+inline void radix_sort_32_impl(T* src, unsigned count, T* dst, F bitwise_transform,
+                               radix_sort_payload<P>... payload)
+{
+    radix_sort_null_observer observer;
+    radix_sort_32_impl<radix_bits>(src, count, dst, bitwise_transform, observer, payload...);
+}
+
+template <unsigned radix_bits = RADIX_SORT_DIGIT_BITS, typename T, typename F, typename O, typename... P>
+inline typename std::enable_if<!radix_sort_is_payload<O>::value>::type
+radix_sort_64_impl(T* src, unsigned count, T* dst, F bitwise_transform, O& observer,
+                   radix_sort_payload<P>... payload)
+{
+    static_assert(sizeof(bitwise_transform(*src)) == 8, "64 bit keys expected");
+
+    radix_sort_lsd_impl<radix_bits>(src, count, dst, bitwise_transform, observer, payload...);
+}
+
+template <unsigned radix_bits = RADIX_SORT_DIGIT_BITS, typename T, typename F, typename... P>
+inline void radix_sort_64_impl(T* src, unsigned count, T* dst, F bitwise_transform,
+                               radix_sort_payload<P>... payload)
+{
+    radix_sort_null_observer observer;
+    radix_sort_64_impl<radix_bits>(src, count, dst, bitwise_transform, observer, payload...);
+}
+
+// Sorts by a key of any width.
+template <typename T, typename F, typename... P>
+inline void radix_sort_impl(T* src, unsigned count, T* dst, F bitwise_transform,
+                            radix_sort_payload<P>... payload)
+{
+    radix_sort_lsd_impl<RADIX_SORT_DIGIT_BITS>(src, count, dst, bitwise_transform, payload...);
+}
+
+// Number of threads for a sort of count elements: requested, or
+// hardware_concurrency() if 0, but at least one and no more than count allows.
+inline unsigned radix_sort_thread_count(unsigned requested, const unsigned count)
+{
+    // Below this many elements per thread, spawning threads costs more than it saves.
+    const unsigned min_elements_per_thread = 1U << 16;
+
+    if (!requested)
+        requested = std::thread::hardware_concurrency();
+
+    if (requested > count / min_elements_per_thread)
+        requested = count / min_elements_per_thread;
+
+    return requested ? requested : 1;
+}
+
+// Runs task(0) .. task(thread_count - 1) concurrently, task(0) on the calling thread.
+template <typename F>
+void radix_sort_parallel_for(const unsigned thread_count, F task)
+{
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count - 1);
+
+    for (unsigned t = 1; t < thread_count; ++t)
+        workers.emplace_back(task, t);
+
+    task(0);
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+// Reusable barrier for the threads of one sort.
+class radix_sort_barrier
+{
+public:
+
+    explicit radix_sort_barrier(const unsigned thread_count)
+        : thread_count(thread_count), waiting(0), generation(0) { }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        const unsigned current = generation;
+
+        if (++waiting == thread_count)
+        {
+            waiting = 0;
+            ++generation;
+            condition.notify_all();
+        }
+        else
+        {
+            condition.wait(lock, [&] { return generation != current; });
+        }
+    }
+
+private:
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    unsigned thread_count;
+    unsigned waiting;
+    unsigned generation;
+};
+
+// Offsets of one slice of a sort split into slice_count slices, for a pass
+// whose histograms of all slices (buckets each, one after another) are
+// counted: buckets go in order, slices in order within a bucket, every
+// offset is one less than the first slot. Returns false if the digit is the
+// same in every element, the pass wouldn't change anything then.
+template <unsigned buckets>
+bool radix_sort_slice_offsets(const unsigned* histograms, const unsigned slice_count, const unsigned slice,
+                              const unsigned first_digit, const unsigned count, unsigned* offsets)
+{
+    unsigned first_digit_count = 0;
+
+    for (unsigned s = 0; s < slice_count; ++s)
+        first_digit_count += histograms[s * buckets + first_digit];
+
+    if (first_digit_count == count)
+        return false;
+
+    unsigned offset = 0;
+
+    for (unsigned value = 0; value < buckets; ++value)
+    {
+        for (unsigned s = 0; s < slice_count; ++s)
+        {
+            if (s == slice)
+                offsets[value] = offset - 1;
+
+            offset += histograms[s * buckets + value];
+        }
+    }
+
+    return true;
+}
+
+// Parallel LSD radix sort, one pass per digit of radix_bits bits, as run
+// by one of slice_count threads (or processes): the array is split into
+// one contiguous slice per thread. For every pass each thread counts the
+// current digit of its slice and waits at the barrier, then turns the
+// counts of all slices into its own offsets and scatters its slice into
+// its own disjoint slots of dst. Slices are processed in order within a
+// bucket, so the sort stays stable. histograms holds two sets of
+// slice_count * buckets: the set of a pass is only counted into again two
+// passes later, when every thread has passed a barrier after reading it.
+template <unsigned radix_bits, typename T, typename F, typename B>
+void radix_sort_parallel_slice(T* src, const unsigned count, T* dst, F bitwise_transform, unsigned* histograms,
+                               const unsigned slice_count, const unsigned slice, B& barrier)
+{
+    typedef radix_sort_digit<radix_bits> digit;
+
+    const unsigned buckets = digit::buckets;
+    const unsigned passes = radix_sort_pass_count<radix_bits, sizeof(bitwise_transform(*src))>::value;
+
+    const unsigned slice_size = count / slice_count;
+    const unsigned slice_begin = slice * slice_size;
+    const unsigned slice_end = slice + 1 == slice_count ? count : slice_begin + slice_size;
+
+    std::vector<unsigned> offsets(buckets);
+
+    bool in_dst = false;
+
+    for (unsigned pass = 0; pass < passes; ++pass)
+    {
+        const digit extract_digit(pass * radix_bits);
+
+        unsigned* pass_histograms = histograms + (pass & 1) * slice_count * buckets;
+        unsigned* hist = pass_histograms + slice * buckets;
+
+        for (unsigned value = 0; value < buckets; ++value)
+            hist[value] = 0;
+
+        for (T* i = src + slice_begin; i != src + slice_end; ++i)
+            hist[extract_digit(bitwise_transform(*i))]++;
+
+        barrier.wait();
+
+        // All threads see the same histograms and skip a pass together.
+        if (!radix_sort_slice_offsets<buckets>(pass_histograms, slice_count, slice,
+                                               extract_digit(bitwise_transform(*src)), count, offsets.data()))
+            continue;
+
+        radix_sort_scatter_chunk(src + slice_begin, slice_end - slice_begin, dst, offsets.data(),
+                                 bitwise_transform, extract_digit, count);
+
+        barrier.wait();
+
+        T* swap_temp = src;
+        src = dst;
+        dst = swap_temp;
+        in_dst = !in_dst;
+    }
+
+    // An odd number of passes was made, the result is in the buffer.
+    if (in_dst)
+    {
+        std::copy(src + slice_begin, src + slice_end, dst + slice_begin);
+
+        barrier.wait();
+    }
+}
+
+// Parallel LSD radix sort: the threads are started once per sort and run
+// radix_sort_parallel_slice, synchronized by a barrier between the phases.
+template <unsigned radix_bits, typename T, typename F>
+void radix_sort_parallel_impl(T* src, const unsigned count, T* dst, F bitwise_transform,
+                              unsigned thread_count)
+{
+    const unsigned buckets = radix_sort_digit<radix_bits>::buckets;
+
+    thread_count = radix_sort_thread_count(thread_count, count);
+
+    if (!count)
+        return;
+
+    std::vector<unsigned> histograms(2 * thread_count * buckets);
+
+    radix_sort_barrier barrier(thread_count);
+
+    radix_sort_parallel_for(thread_count, [&](unsigned t)
+    {
+        radix_sort_parallel_slice<radix_bits>(src, count, dst, bitwise_transform, histograms.data(),
+                                              thread_count, t, barrier);
+    });
+}
+
+template <typename T, typename F>
+void radix_sort_insertion_sort(T* src, const unsigned count, F bitwise_transform)
+{
+    for (unsigned i = 1; i < count; ++i)
+    {
+        T value = src[i];
+        auto key = bitwise_transform(value);
+
+        unsigned j = i;
+
+        for (; j && key < bitwise_transform(src[j - 1]); --j)
+            src[j] = src[j - 1];
+
+        src[j] = value;
+    }
+}
+
+// In-place MSD radix sort (American flag sort), O(1) extra memory
+// besides one histogram per recursion level. Elements are permuted into
+// the buckets of the byte at shift by walking cycles, then every bucket
+// is sorted by the next byte. Not stable.
+template <typename T, typename F>
+void radix_sort_msd_in_place_impl(T* src, const unsigned count, F bitwise_transform, const unsigned shift)
+{
+    typedef decltype(bitwise_transform(*src)) key_type;
+
+    // Buckets this small are faster to finish with insertion sort.
+    const unsigned insertion_sort_threshold = 64;
+
+    if (count <= insertion_sort_threshold)
+    {
+        radix_sort_insertion_sort(src, count, bitwise_transform);
+        return;
+    }
+
+    auto extract_byte = [shift](key_type value) -> unsigned
+    {
+        return (value >> shift) & lsb_mask;
+    };
+
+    unsigned histogram[values_in_byte] = { 0 };
+
+    for (unsigned i = 0; i < count; ++i)
+        histogram[extract_byte(bitwise_transform(src[i]))]++;
+
+    // All elements share the byte, there is nothing to permute.
+    if (histogram[extract_byte(bitwise_transform(*src))] == count)
+    {
+        if (shift)
+            radix_sort_msd_in_place_impl(src, count, bitwise_transform, shift - CHAR_BIT);
+        return;
+    }
+
+    unsigned bucket_begin[values_in_byte];
+    unsigned bucket_next[values_in_byte];
+
+    unsigned offset = 0;
+
+    for (unsigned value = 0; value < values_in_byte; ++value)
+    {
+        bucket_begin[value] = offset;
+        bucket_next[value] = offset;
+        offset += histogram[value];
+    }
+
+    for (unsigned value = 0; value < values_in_byte; ++value)
+    {
+        const unsigned bucket_end = bucket_begin[value] + histogram[value];
+
+        while (bucket_next[value] != bucket_end)
+        {
+            T element = src[bucket_next[value]];
+            unsigned element_byte = extract_byte(bitwise_transform(element));
+
+            while (element_byte != value)
+            {
+                T displaced = src[bucket_next[element_byte]];
+                src[bucket_next[element_byte]++] = element;
+                element = displaced;
+                element_byte = extract_byte(bitwise_transform(element));
+            }
+
+            src[bucket_next[value]++] = element;
+        }
+    }
+
+    if (!shift)
+        return;
+
+    for (unsigned value = 0; value < values_in_byte; ++value)
+        if (histogram[value] > 1)
+            radix_sort_msd_in_place_impl(src + bucket_begin[value], histogram[value],
+                                         bitwise_transform, shift - CHAR_BIT);
+}
+
+template <typename T, typename F>
+inline void radix_sort_in_place_impl(T* src, const unsigned count, F bitwise_transform)
+{
+    const unsigned top_byte_shift = (sizeof(bitwise_transform(*src)) - 1) * CHAR_BIT;
+
+    radix_sort_msd_in_place_impl(src, count, bitwise_transform, top_byte_shift);
+}
+
+// Radix select: moves the element that would be at index k after sorting
+// to index k, smaller ones before it and larger ones after it. Every level
+// builds the histogram of one byte of the remaining range, finds the bucket
+// that contains k and partitions the range into the elements below, in and
+// above that bucket; only the bucket itself is looked at on the next level.
+template <typename T, typename F>
+void radix_select_impl(T* src, const unsigned count, const unsigned k, F bitwise_transform)
+{
+    typedef decltype(bitwise_transform(*src)) key_type;
+
+    // Ranges this small are faster to finish with insertion sort.
+    const unsigned insertion_sort_threshold = 64;
+
+    if (k >= count)
+        return;
+
+    unsigned shift = (sizeof(key_type) - 1) * CHAR_BIT;
+    unsigned begin = 0;
+    unsigned end = count;
+
+    while (end - begin > insertion_sort_threshold)
+    {
+        auto extract_byte = [shift](key_type value) -> unsigned
+        {
+            return (value >> shift) & lsb_mask;
+        };
+
+        unsigned histogram[values_in_byte] = { 0 };
+
+        for (unsigned i = begin; i < end; ++i)
+            histogram[extract_byte(bitwise_transform(src[i]))]++;
+
+        unsigned bucket = 0;
+        unsigned below = 0;
+
+        while (below + histogram[bucket] <= k - begin)
+            below += histogram[bucket++];
+
+        // All elements share the byte, there is nothing to partition.
+        if (histogram[bucket] != end - begin)
+        {
+            unsigned less = begin;
+            unsigned greater = end;
+
+            for (unsigned i = begin; i < greater; )
+            {
+                const unsigned value = extract_byte(bitwise_transform(src[i]));
+
+                if (value < bucket)
+                    std::swap(src[less++], src[i++]);
+                else if (value > bucket)
+                    std::swap(src[i], src[--greater]);
+                else
+                    ++i;
+            }
+
+            begin += below;
+            end = begin + histogram[bucket];
+        }
+
+        // The remaining elements are equal.
+        if (!shift)
+            return;
+
+        shift -= CHAR_BIT;
+    }
+
+    radix_sort_insertion_sort(src + begin, end - begin, bitwise_transform);
+}
+
+#undef COPY_WITH_REORDERING_UNROLLED
+
+enum class radix_sort_order
+{
+    ascending,
+    descending
+};
+
+// Turns a bitwise_transform for ascending order into one for descending
+// order by inverting all bits of the key. Equal keys stay equal,
+// so stable sorts stay stable.
+template <typename F>
+struct radix_sort_descending
+{
+    F transform;
+
+    explicit radix_sort_descending(F transform) : transform(transform) { }
+
+    template <typename T>
+    auto operator()(const T& value) const -> decltype(transform(value))
+    {
+        typedef decltype(transform(value)) key_type;
+
+        return key_type(~transform(value));
+    }
+};
+
+template <typename T, typename F, typename... P>
+inline void radix_sort_ordered_impl(T* src, unsigned count, T* dst, F bitwise_transform,
+                                    radix_sort_order order, radix_sort_payload<P>... payload)
+{
+    if (order == radix_sort_order::descending)
+        radix_sort_impl(src, count, dst, radix_sort_descending<F>(bitwise_transform), payload...);
+    else
+        radix_sort_impl(src, count, dst, bitwise_transform, payload...);
+}
+
+template <typename T, typename F>
+inline void radix_sort_parallel_ordered_impl(T* src, unsigned count, T* dst, F bitwise_transform,
+                                             unsigned thread_count, radix_sort_order order)
+{
+    if (order == radix_sort_order::descending)
+        radix_sort_parallel_impl<RADIX_SORT_DIGIT_BITS>(src, count, dst, radix_sort_descending<F>(bitwise_transform),
+                                                        thread_count);
+    else
+        radix_sort_parallel_impl<RADIX_SORT_DIGIT_BITS>(src, count, dst, bitwise_transform, thread_count);
+}
+
+template <typename T, typename F>
+inline void radix_sort_in_place_ordered_impl(T* src, unsigned count, F bitwise_transform, radix_sort_order order)
+{
+    if (order == radix_sort_order::descending)
+        radix_sort_in_place_impl(src, count, radix_sort_descending<F>(bitwise_transform));
+    else
+        radix_sort_in_place_impl(src, count, bitwise_transform);
+}
+
+template <typename T, typename F, typename... P>
+inline void radix_sort_workspace_impl(T* src, unsigned count, T* dst, F bitwise_transform,
+                                      radix_sort_workspace& workspace, radix_sort_payload<P>... payload)
+{
+    const unsigned histogram_size =
+        radix_sort_histogram_size<RADIX_SORT_DIGIT_BITS, sizeof(bitwise_transform(*src))>::value;
+
+    radix_sort_null_observer observer;
+
+    radix_sort_lsd_with_histograms<RADIX_SORT_DIGIT_BITS>(src, count, dst, bitwise_transform, observer,
+                                                          workspace.histograms(histogram_size), payload...);
+}
+
+template <typename T, typename F, typename... P>
+inline void radix_sort_workspace_ordered_impl(T* src, unsigned count, T* dst, F bitwise_transform,
+                                              radix_sort_workspace& workspace, radix_sort_order order,
+                                              radix_sort_payload<P>... payload)
+{
+    if (order == radix_sort_order::descending)
+        radix_sort_workspace_impl(src, count, dst, radix_sort_descending<F>(bitwise_transform), workspace, payload...);
+    else
+        radix_sort_workspace_impl(src, count, dst, bitwise_transform, workspace, payload...);
+}
+
+// Gives every payload column a buffer from the workspace, starting at
+// cursor. One column per call: it is taken from the front and put back
+// at the end as a radix_sort_payload, so the columns keep their order.
+template <unsigned remaining, typename K, typename F, typename A, typename... Args>
+inline typename std::enable_if<remaining != 0>::type
+radix_sort_workspace_payload_impl(K* keys, unsigned count, K* keys_temp, F bitwise_transform,
+                                  radix_sort_workspace& workspace, radix_sort_order order, char* cursor,
+                                  A* column, Args... rest)
+{
+    A* column_temp = reinterpret_cast<A*>(cursor);
+
+    radix_sort_workspace_payload_impl<remaining - 1>(keys, count, keys_temp, bitwise_transform, workspace, order,
+        cursor + radix_sort_workspace::aligned_size(size_t(count) * sizeof(A)),
+        rest..., radix_sort_make_payload(column, column_temp));
+}
+
+template <unsigned remaining, typename K, typename F, typename... P>
+inline typename std::enable_if<remaining == 0>::type
+radix_sort_workspace_payload_impl(K* keys, unsigned count, K* keys_temp, F bitwise_transform,
+                                  radix_sort_workspace& workspace, radix_sort_order order, char*,
+                                  radix_sort_payload<P>... payload)
+{
+    radix_sort_workspace_ordered_impl(keys, count, keys_temp, bitwise_transform, workspace, order, payload...);
+}
+
+// Sorts segments first .. last - 1, segment s being
+// data[segment_offsets[s]] .. data[segment_offsets[s + 1] - 1].
+// Every segment gets the cheapest kernel for its size: insertion sort for
+// tiny ones, the in-place MSD sort for short ones with 64 bit keys (which
+// would need 8 LSD passes), LSD sort with the workspace buffer otherwise.
+template <typename T, typename F>
+void radix_sort_segments_impl(T* data, const unsigned* segment_offsets, const unsigned first, const unsigned last,
+                              F bitwise_transform, radix_sort_workspace& workspace)
+{
+    const unsigned insertion_sort_threshold = 48;
+    const unsigned msd_threshold = sizeof(bitwise_transform(*data)) > 4 ? 256 : 0;
+
+    for (unsigned segment = first; segment < last; ++segment)
+    {
+        T* src = data + segment_offsets[segment];
+        const unsigned count = segment_offsets[segment + 1] - segment_offsets[segment];
+
+        if (count <= insertion_sort_threshold)
+            radix_sort_insertion_sort(src, count, bitwise_transform);
+        else if (count < msd_threshold)
+            radix_sort_in_place_impl(src, count, bitwise_transform);
+        else
+            radix_sort_workspace_impl(src, count, workspace.buffer<T>(count), bitwise_transform, workspace);
+    }
+}
+
+// Splits the segments between threads by number of elements, every thread
+// gets its own workspace. thread_count == 0 means hardware_concurrency().
+template <typename T, typename F>
+void radix_sort_segmented_parallel_impl(T* data, const unsigned* segment_offsets, const unsigned num_segments,
+                                        F bitwise_transform, unsigned thread_count)
+{
+    if (!num_segments)
+        return;
+
+    const unsigned begin = segment_offsets[0];
+    const unsigned total = segment_offsets[num_segments] - begin;
+
+    thread_count = radix_sort_thread_count(thread_count, total);
+
+    if (thread_count > num_segments)
+        thread_count = num_segments;
+
+    if (thread_count <= 1)
+    {
+        radix_sort_workspace workspace;
+        radix_sort_segments_impl(data, segment_offsets, 0, num_segments, bitwise_transform, workspace);
+        return;
+    }
+
+    std::vector<unsigned> first_segment(thread_count + 1);
+
+    for (unsigned t = 0; t < thread_count; ++t)
+    {
+        const unsigned start = begin + unsigned(uint64_t(total) * t / thread_count);
+
+        first_segment[t] = unsigned(std::lower_bound(segment_offsets, segment_offsets + num_segments, start)
+                                    - segment_offsets);
+    }
+
+    first_segment[thread_count] = num_segments;
+
+    radix_sort_parallel_for(thread_count, [&](unsigned t)
+    {
+        radix_sort_workspace workspace;
+        radix_sort_segments_impl(data, segment_offsets, first_segment[t], first_segment[t + 1],
+                                 bitwise_transform, workspace);
+    });
+}
+
+template <typename T, typename F>
+inline void radix_select_ordered_impl(T* src, unsigned count, unsigned k, F bitwise_transform, radix_sort_order order)
+{
+    if (order == radix_sort_order::descending)
+        radix_select_impl(src, count, k, radix_sort_descending<F>(bitwise_transform));
+    else
+        radix_select_impl(src, count, k, bitwise_transform);
+}
+
+// Merging of a sorted batch into a sorted array. On equal keys the
+// elements of the array come first, so merging batch after batch is stable.
+
+// First element of [first, last) with a key greater than key, searched
+// from first with steps of 1, 2, 4, ... and a binary search in the last
+// step: O(log distance) comparisons.
+template <typename T, typename K, typename F>
+inline const T* radix_sort_gallop_forward(const T* first, const T* last, const K key, F bitwise_transform)
+{
+    const size_t size = size_t(last - first);
+
+    size_t high = 1;
+
+    while (high <= size && !(key < bitwise_transform(first[high - 1])))
+        high *= 2;
+
+    const size_t low = high / 2;
+
+    if (high > size)
+        high = size;
+
+    return std::upper_bound(first + low, first + high, key, [&bitwise_transform](const K& k, const T& value)
+    {
+        return k < bitwise_transform(value);
+    });
+}
+
+// The same, searched from last backwards.
+template <typename T, typename K, typename F>
+inline T* radix_sort_gallop_backward(T* first, T* last, const K key, F bitwise_transform)
+{
+    const size_t size = size_t(last - first);
+
+    size_t high = 1;
+
+    while (high <= size && key < bitwise_transform(last[-ptrdiff_t(high)]))
+        high *= 2;
+
+    const size_t low = high / 2;
+
+    if (high > size)
+        high = size;
+
+    return std::upper_bound(last - high, last - low, key, [&bitwise_transform](const K& k, const T& value)
+    {
+        return k < bitwise_transform(value);
+    });
+}
+
+// Small batches gallop over the runs of array elements between two batch
+// elements and move them with one copy, larger ones use a branch-free merge.
+template <size_t min_ratio>
+inline bool radix_sort_merge_gallops(const size_t sorted_count, const unsigned batch_count)
+{
+    return sorted_count >= min_ratio * batch_count;
+}
+
+// Merges batch into sorted in place, from the back; sorted has room for
+// sorted_count + batch_count elements. Elements of sorted not greater than
+// the smallest batch element aren't touched.
+template <typename T, typename F>
+void radix_sort_merge_in_place_impl(T* sorted, const size_t sorted_count, const T* batch, const unsigned batch_count,
+                                    F bitwise_transform)
+{
+    T* a = sorted + sorted_count;
+    const T* b = batch + batch_count;
+    T* out = a + batch_count;
+
+    if (radix_sort_merge_gallops<8>(sorted_count, batch_count))
+    {
+        while (b != batch)
+        {
+            --b;
+
+            T* run = radix_sort_gallop_backward(sorted, a, bitwise_transform(*b), bitwise_transform);
+
+            out = std::copy_backward(run, a, out);
+            a = run;
+
+            *--out = *b;
+        }
+
+        return;
+    }
+
+    while (b != batch && a != sorted)
+    {
+        const bool take_a = bitwise_transform(b[-1]) < bitwise_transform(a[-1]);
+
+        *--out = take_a ? a[-1] : b[-1];
+
+        a -= take_a;
+        b -= !take_a;
+    }
+
+    std::copy_backward(batch, b, out);
+}
+
+// Merges sorted and batch into dst.
+template <typename T, typename F>
+void radix_sort_merge_to_impl(const T* sorted, const size_t sorted_count, const T* batch, const unsigned batch_count,
+                              T* dst, F bitwise_transform)
+{
+    const T* a = sorted;
+    const T* a_end = sorted + sorted_count;
+    const T* b = batch;
+    const T* b_end = batch + batch_count;
+
+    if (radix_sort_merge_gallops<8>(sorted_count, batch_count))
+    {
+        for (; b != b_end; ++b)
+        {
+            const T* run_end = radix_sort_gallop_forward(a, a_end, bitwise_transform(*b), bitwise_transform);
+
+            dst = std::copy(a, run_end, dst);
+            a = run_end;
+
+            *dst++ = *b;
+        }
+    }
+    else
+    {
+        while (a != a_end && b != b_end)
+        {
+            const bool take_b = bitwise_transform(*b) < bitwise_transform(*a);
+
+            *dst++ = take_b ? *b : *a;
+
+            b += take_b;
+            a += !take_b;
+        }
+
+        dst = std::copy(b, b_end, dst);
+    }
+
+    std::copy(a, a_end, dst);
+}
+
+void radix_sort(uint8_t * src, const unsigned count, radix_sort_order order = radix_sort_order::ascending)
+{    
+    unsigned histogram[values_in_byte] = { 0 };
+
+    for(unsigned i = 0; i < count; ++i)
+        ++histogram[src[i]];
+
+    unsigned write_index = 0;
+
+    for(unsigned bucket = 0; bucket < values_in_byte; ++bucket)
+    {
+        const unsigned value = order == radix_sort_order::descending ? lsb_mask - bucket : bucket;
+
+        const unsigned element_count = histogram[value];
+
+        for (unsigned i = 0; i < element_count; ++i, ++write_index)
+            src[write_index] = uint8_t(value);
+    }
+}
+
+void radix_sort(int8_t * src, unsigned count, radix_sort_order order = radix_sort_order::ascending)
+{
+    unsigned histogram[values_in_byte] = { 0 };
+
+    for(unsigned i = 0; i < count; ++i)
+        ++histogram[int32_t(src[i]) + int32_t(128)];
+
+    unsigned write_index = 0;
+
+    for(unsigned bucket = 0; bucket < values_in_byte; ++bucket)
+    {
+        const int32_t value = int32_t(order == radix_sort_order::descending ? lsb_mask - bucket : bucket);
+
+        const unsigned element_count = histogram[value];
+
+        const int8_t write_value = int8_t(value - int32_t(128));
+
+        for (unsigned i = 0; i < element_count; ++i, ++write_index)
+            src[write_index] = write_value;
+    }
+}
+
+// Maps every supported type onto an unsigned integer of the same width,
+// whose natural order is the ascending order of the original values.
+struct radix_sort_transform
+{
+    uint8_t operator()(uint8_t v) const
+    {
+        return v;
+    }
+
+    uint8_t operator()(int8_t v) const
+    {
+        return uint8_t(v) ^ (uint8_t(1) << 7);
+    }
+
+    uint16_t operator()(uint16_t v) const
+    {
+        return v;
+    }
+
+    uint16_t operator()(int16_t v) const
+    {
+        return  *reinterpret_cast<uint16_t*>(&v) ^ (uint16_t(1) << 15);
+    }
+
+    uint32_t operator()(uint32_t v) const
+    {
+        return v;
+    }
+
+    uint32_t operator()(int32_t v) const
+    {
+        return  *reinterpret_cast<uint32_t*>(&v) ^ (uint32_t(1) << 31);
+    }
+
+    uint64_t operator()(uint64_t v) const
+    {
+        return v;
+    }
+
+    uint64_t operator()(int64_t v) const
+    {
+        return  *reinterpret_cast<uint64_t*>(&v) ^ (uint64_t(1) << 63);
+    }
+
+    uint32_t operator()(float v) const
+    {
+        // if floats are guaranteed to be >= 0,
+        // you can do this(will be a bit faster):
+        // return *reinterpret_cast<uint32_t*>(&v);
+        // otherwise:
+        uint32_t as_uint;
+        memcpy(&as_uint, &v, sizeof(as_uint));
+        uint32_t mask = -int32_t(as_uint >> 31) | (uint32_t(1) << 31);
+        return as_uint ^ mask;
+    }
+
+    uint64_t operator()(double v) const
+    {
+        // same as for float: flip all bits of negative values,
+        // only the sign bit of positive ones
+        uint64_t as_uint;
+        memcpy(&as_uint, &v, sizeof(as_uint));
+        uint64_t mask = -int64_t(as_uint >> 63) | (uint64_t(1) << 63);
+        return as_uint ^ mask;
+    }
+
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 operator()(unsigned __int128 v) const
+    {
+        return v;
+    }
+
+    unsigned __int128 operator()(__int128 v) const
+    {
+        return static_cast<unsigned __int128>(v) ^ (static_cast<unsigned __int128>(1) << 127);
+    }
+#endif
+};
+
+void radix_sort(uint16_t* src, unsigned count, uint16_t* temp,
+                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_ordered_impl(src, count, temp, radix_sort_transform(), order);
+}
+
+void radix_sort(int16_t* src, unsigned count, int16_t* temp,
+                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_ordered_impl(src, count, temp, radix_sort_transform(), order);
+}
+
+void radix_sort(uint32_t * src, unsigned count, uint32_t* temp,
+                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_ordered_impl(src, count, temp, radix_sort_transform(), order);
+}
+
+void radix_sort(int32_t * src, unsigned count, int32_t* temp,
+                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_ordered_impl(src, count, temp, radix_sort_transform(), order);
+}
+
+void radix_sort(uint64_t* src, unsigned count, uint64_t* temp,
+                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_ordered_impl(src, count, temp, radix_sort_transform(), order);
+}
+
+void radix_sort(int64_t * src, unsigned count, int64_t* temp,
+                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_ordered_impl(src, count, temp, radix_sort_transform(), order);
+}
+
+void radix_sort(float* src, unsigned count, float* temp,
+                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_ordered_impl(src, count, temp, radix_sort_transform(), order);
+}
+
+void radix_sort(double* src, unsigned count, double* temp,
+                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_ordered_impl(src, count, temp, radix_sort_transform(), order);
+}
+
+#ifdef __SIZEOF_INT128__
+// 128 bit versions: 16 passes, digits that are the same in all keys
+// (like the high half of small values) are skipped.
+void radix_sort(unsigned __int128* src, unsigned count, unsigned __int128* temp,
+                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_ordered_impl(src, count, temp, radix_sort_transform(), order);
+}
+
+void radix_sort(__int128* src, unsigned count, __int128* temp,
+                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_ordered_impl(src, count, temp, radix_sort_transform(), order);
+}
+#endif
+
+// Sorts keys and reorders every payload column the same way.
+// K is any of the 16/32/64 bit types or float, each payload
+// is made with radix_sort_make_payload(data, temp).
+template <typename K, typename... P>
+void radix_sort_with_payload(K* keys, unsigned count, K* keys_temp, radix_sort_payload<P>... payload)
+{
+    radix_sort_impl(keys, count, keys_temp, radix_sort_transform(), payload...);
+}
+
+// Same, in the given order. Equal keys keep their order in both cases.
+template <typename K, typename... P>
+void radix_sort_with_payload(K* keys, unsigned count, K* keys_temp, radix_sort_order order,
+                             radix_sort_payload<P>... payload)
+{
+    radix_sort_ordered_impl(keys, count, keys_temp, radix_sort_transform(), order, payload...);
+}
+
+template <unsigned size, bool is_signed>
+struct radix_sort_integer;
+
+template <> struct radix_sort_integer<1, false> { typedef uint8_t type; };
+template <> struct radix_sort_integer<1, true> { typedef int8_t type; };
+template <> struct radix_sort_integer<2, false> { typedef uint16_t type; };
+template <> struct radix_sort_integer<2, true> { typedef int16_t type; };
+template <> struct radix_sort_integer<4, false> { typedef uint32_t type; };
+template <> struct radix_sort_integer<4, true> { typedef int32_t type; };
+template <> struct radix_sort_integer<8, false> { typedef uint64_t type; };
+template <> struct radix_sort_integer<8, true> { typedef int64_t type; };
+#ifdef __SIZEOF_INT128__
+template <> struct radix_sort_integer<16, false> { typedef unsigned __int128 type; };
+template <> struct radix_sort_integer<16, true> { typedef __int128 type; };
+#endif
+
+// The type radix_sort_transform is called with for a key of type K.
+// Integers are mapped to the fixed width type of the same size and
+// signedness (8 bit keys are widened to 16 bits), floats stay as they are.
+template <typename K, bool is_integral = std::is_integral<K>::value>
+struct radix_sort_key_type
+{
+    typedef K type;
+};
+
+template <typename K>
+struct radix_sort_key_type<K, true>
+{
+    typedef typename radix_sort_integer<(sizeof(K) < 2 ? 2 : sizeof(K)),
+                                        std::is_signed<K>::value>::type type;
+};
+
+// bitwise_transform for records: projects a record on its key,
+// then transforms the key.
+template <typename KeyFn>
+struct radix_sort_key_transform
+{
+    KeyFn key;
+
+    explicit radix_sort_key_transform(KeyFn key) : key(key) { }
+
+    template <typename T>
+    auto operator()(const T& record) const
+        -> decltype(radix_sort_transform()(typename radix_sort_key_type<
+                    typename std::decay<decltype(key(record))>::type>::type()))
+    {
+        typedef typename radix_sort_key_type<
+                    typename std::decay<decltype(key(record))>::type>::type key_type;
+
+        return radix_sort_transform()(key_type(key(record)));
+    }
+};
+
+// Sorts records by key(record). The key can be of any arithmetic type
+// radix_sort supports, the number of passes is picked from its width.
+// temp should have at least count elements. The sort is stable.
+template <typename T, typename KeyFn>
+void radix_sort_by_key(T* records, unsigned count, KeyFn key, T* temp,
+                       radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_ordered_impl(records, count, temp, radix_sort_key_transform<KeyFn>(key), order);
+}
+
+// Composite keys: pairs, tuples and byte arrays, in lexicographic order.
+// Every component gets its own stable LSD sort, from the last (least
+// significant) component to the first, with the transform of its type.
+
+// Component I of a pair or tuple.
+template <size_t I>
+struct radix_sort_tuple_element
+{
+    template <typename T>
+    auto operator()(const T& value) const -> decltype(std::get<I>(value))
+    {
+        return std::get<I>(value);
+    }
+};
+
+// Bytes 8 * I .. 8 * I + 7 of a byte array as a big endian number,
+// bytes past the end of the array are zero.
+template <size_t I>
+struct radix_sort_array_chunk
+{
+    template <typename B, size_t N>
+    uint64_t operator()(const std::array<B, N>& bytes) const
+    {
+        uint64_t chunk = 0;
+
+        for (size_t byte = 8 * I; byte < 8 * I + 8; ++byte)
+            chunk = (chunk << 8) | (byte < N ? uint8_t(bytes[byte]) : 0U);
+
+        return chunk;
+    }
+};
+
+// Sorts by components I, I - 1, .. 0.
+template <template <size_t> class Component, size_t I>
+struct radix_sort_components
+{
+    template <typename T>
+    static void sort(T* src, unsigned count, T* temp, radix_sort_order order)
+    {
+        radix_sort_ordered_impl(src, count, temp, radix_sort_key_transform<Component<I> >(Component<I>()), order);
+        radix_sort_components<Component, I - 1>::sort(src, count, temp, order);
+    }
+};
+
+template <template <size_t> class Component>
+struct radix_sort_components<Component, 0>
+{
+    template <typename T>
+    static void sort(T* src, unsigned count, T* temp, radix_sort_order order)
+    {
+        radix_sort_ordered_impl(src, count, temp, radix_sort_key_transform<Component<0> >(Component<0>()), order);
+    }
+};
+
+// Components can be of any arithmetic type radix_sort supports.
+template <typename A, typename B>
+void radix_sort(std::pair<A, B>* src, unsigned count, std::pair<A, B>* temp,
+                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_components<radix_sort_tuple_element, 1>::sort(src, count, temp, order);
+}
+
+template <typename... E>
+void radix_sort(std::tuple<E...>* src, unsigned count, std::tuple<E...>* temp,
+                radix_sort_order order = radix_sort_order::ascending)
+{
+    static_assert(sizeof...(E) != 0, "tuples without components have no order");
+
+    radix_sort_components<radix_sort_tuple_element, sizeof...(E) - 1>::sort(src, count, temp, order);
+}
+
+// Byte arrays (UUIDs, hashes, fixed length strings) compare as unsigned bytes.
+template <size_t N>
+void radix_sort(std::array<unsigned char, N>* src, unsigned count, std::array<unsigned char, N>* temp,
+                radix_sort_order order = radix_sort_order::ascending)
+{
+    static_assert(N != 0, "empty arrays have no order");
+
+    radix_sort_components<radix_sort_array_chunk, (N - 1) / 8>::sort(src, count, temp, order);
+}
+
+template <size_t N>
+void radix_sort(std::array<char, N>* src, unsigned count, std::array<char, N>* temp,
+                radix_sort_order order = radix_sort_order::ascending)
+{
+    static_assert(N != 0, "empty arrays have no order");
+
+    radix_sort_components<radix_sort_array_chunk, (N - 1) / 8>::sort(src, count, temp, order);
+}
+
+// The order radix_sort gives elements, as a comparison: true if a goes
+// before b. For merges of sorted data, e.g. the runs of radix_sort_file.
+struct radix_sort_transform_less
+{
+    radix_sort_order order;
+
+    explicit radix_sort_transform_less(radix_sort_order order) : order(order) { }
+
+    template <typename T>
+    bool operator()(const T& a, const T& b) const
+    {
+        const auto key_a = radix_sort_transform()(a);
+        const auto key_b = radix_sort_transform()(b);
+
+        return order == radix_sort_order::descending ? key_b < key_a : key_a < key_b;
+    }
+};
+
+// Composite keys compare component by component, from the first to the
+// last one, each with the transform its sort uses.
+template <template <size_t> class Component, size_t last>
+struct radix_sort_components_less
+{
+    radix_sort_order order;
+
+    explicit radix_sort_components_less(radix_sort_order order) : order(order) { }
+
+    template <typename T>
+    bool operator()(const T& a, const T& b) const
+    {
+        return before(a, b, std::integral_constant<size_t, 0>());
+    }
+
+private:
+
+    template <typename T, size_t I>
+    bool before(const T& a, const T& b, std::integral_constant<size_t, I>) const
+    {
+        const radix_sort_key_transform<Component<I> > transform((Component<I>()));
+
+        const auto key_a = transform(a);
+        const auto key_b = transform(b);
+
+        if (key_a != key_b)
+            return order == radix_sort_order::descending ? key_b < key_a : key_a < key_b;
+
+        return before(a, b, std::integral_constant<size_t, I + 1>());
+    }
+
+    template <typename T>
+    bool before(const T&, const T&, std::integral_constant<size_t, last + 1>) const
+    {
+        return false;
+    }
+};
+
+template <typename T>
+inline radix_sort_transform_less radix_sort_less(const T*, radix_sort_order order)
+{
+    return radix_sort_transform_less(order);
+}
+
+template <typename A, typename B>
+inline radix_sort_components_less<radix_sort_tuple_element, 1>
+radix_sort_less(const std::pair<A, B>*, radix_sort_order order)
+{
+    return radix_sort_components_less<radix_sort_tuple_element, 1>(order);
+}
+
+template <typename... E>
+inline radix_sort_components_less<radix_sort_tuple_element, sizeof...(E) - 1>
+radix_sort_less(const std::tuple<E...>*, radix_sort_order order)
+{
+    return radix_sort_components_less<radix_sort_tuple_element, sizeof...(E) - 1>(order);
+}
+
+template <typename B, size_t N>
+inline radix_sort_components_less<radix_sort_array_chunk, (N - 1) / 8>
+radix_sort_less(const std::array<B, N>*, radix_sort_order order)
+{
+    return radix_sort_components_less<radix_sort_array_chunk, (N - 1) / 8>(order);
+}
+
+// A key of length bytes at data, compared as a sequence of unsigned bytes.
+struct radix_sort_byte_key
+{
+    const char* data;
+    size_t length;
+};
+
+inline const unsigned char* radix_sort_key_bytes(const std::string& key)
+{
+    return reinterpret_cast<const unsigned char*>(key.data());
+}
+
+inline size_t radix_sort_key_length(const std::string& key)
+{
+    return key.size();
+}
+
+#if __cplusplus >= 201703L
+inline const unsigned char* radix_sort_key_bytes(std::string_view key)
+{
+    return reinterpret_cast<const unsigned char*>(key.data());
+}
+
+inline size_t radix_sort_key_length(std::string_view key)
+{
+    return key.size();
+}
+#endif
+
+inline const unsigned char* radix_sort_key_bytes(const radix_sort_byte_key& key)
+{
+    return reinterpret_cast<const unsigned char*>(key.data);
+}
+
+inline size_t radix_sort_key_length(const radix_sort_byte_key& key)
+{
+    return key.length;
+}
+
+// Compares the parts of two keys that start at depth.
+template <typename T>
+inline bool radix_sort_key_less(const T& a, const T& b, const size_t depth, const bool descending)
+{
+    const size_t a_length = radix_sort_key_length(a) - depth;
+    const size_t b_length = radix_sort_key_length(b) - depth;
+
+    int result = std::memcmp(radix_sort_key_bytes(a) + depth, radix_sort_key_bytes(b) + depth,
+                             a_length < b_length ? a_length : b_length);
+
+    if (!result)
+        result = a_length < b_length ? -1 : (a_length > b_length ? 1 : 0);
+
+    return descending ? result > 0 : result < 0;
+}
+
+template <typename T>
+void radix_sort_string_insertion_sort(T* src, const unsigned count, const size_t depth, const bool descending)
+{
+    for (unsigned i = 1; i < count; ++i)
+    {
+        for (unsigned j = i; j && radix_sort_key_less(src[j], src[j - 1], depth, descending); --j)
+        {
+            using std::swap;
+            swap(src[j], src[j - 1]);
+        }
+    }
+}
+
+// MSD radix sort of byte strings, one byte per level.
+// Keys that end at depth go to their own bucket, before all others
+// (after all others in descending order). The bucket of every key is read
+// from its characters once per level and kept in bucket_cache, which is
+// permuted together with the keys. Keys are moved only with swap, which is
+// cheap for std::string. Buckets of up to 32 keys are finished with
+// insertion sort, a byte that is the same in all keys just moves on to the
+// next one. Not stable.
+template <typename T>
+void radix_sort_string_impl(T* src, unsigned count, uint16_t* bucket_cache, size_t depth,
+                            const bool descending)
+{
+    const unsigned insertion_sort_threshold = 32;
+
+    // Index of the bucket of keys that end at depth.
+    const unsigned ended_bucket = values_in_byte;
+
+    auto bucket_of = [&](const T& key) -> unsigned
+    {
+        if (radix_sort_key_length(key) <= depth)
+            return ended_bucket;
+
+        const unsigned value = radix_sort_key_bytes(key)[depth];
+
+        return descending ? lsb_mask - value : value;
+    };
+
+    while (count > insertion_sort_threshold)
+    {
+        unsigned histogram[values_in_byte] = { 0 };
+        unsigned ended = 0;
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            const unsigned bucket = bucket_of(src[i]);
+
+            bucket_cache[i] = uint16_t(bucket);
+
+            if (bucket == ended_bucket)
+                ++ended;
+            else
+                ++histogram[bucket];
+        }
+
+        // All keys are equal.
+        if (ended == count)
+            return;
+
+        // All keys share the byte, nothing to permute.
+        if (bucket_cache[0] != ended_bucket && histogram[bucket_cache[0]] == count)
+        {
+            ++depth;
+            continue;
+        }
+
+        unsigned bucket_next[values_in_byte + 1];
+        unsigned bucket_end[values_in_byte + 1];
+
+        for (unsigned bucket = 0; bucket < values_in_byte; ++bucket)
+            bucket_end[bucket] = histogram[bucket];
+
+        radix_sort_calculate_offset_table<1, values_in_byte>(histogram, descending ? 0 : ended);
+
+        for (unsigned bucket = 0; bucket < values_in_byte; ++bucket)
+        {
+            bucket_next[bucket] = histogram[bucket] + 1;
+            bucket_end[bucket] += bucket_next[bucket];
+        }
+
+        bucket_next[ended_bucket] = descending ? count - ended : 0;
+        bucket_end[ended_bucket] = bucket_next[ended_bucket] + ended;
+
+        for (unsigned bucket = 0; bucket <= values_in_byte; ++bucket)
+        {
+            while (bucket_next[bucket] != bucket_end[bucket])
+            {
+                const unsigned from = bucket_next[bucket];
+                const unsigned target = bucket_cache[from];
+
+                if (target == bucket)
+                {
+                    ++bucket_next[bucket];
+                }
+                else
+                {
+                    const unsigned to = bucket_next[target]++;
+
+                    using std::swap;
+                    swap(src[from], src[to]);
+                    swap(bucket_cache[from], bucket_cache[to]);
+                }
+            }
+        }
+
+        // bucket_end of a byte bucket is now also the end of the previous one.
+        // The largest bucket is sorted by the next round of the loop, the
+        // others recursively: they have at most half of the keys each, so
+        // the recursion is at most log2(count) deep even when the keys are
+        // prefixes of each other.
+        unsigned begin = descending ? 0 : ended;
+        unsigned largest_begin = begin;
+        unsigned largest_count = 0;
+
+        for (unsigned bucket = 0; bucket < values_in_byte; ++bucket)
+        {
+            const unsigned bucket_count = bucket_end[bucket] - begin;
+
+            if (bucket_count > largest_count)
+            {
+                largest_begin = begin;
+                largest_count = bucket_count;
+            }
+
+            begin = bucket_end[bucket];
+        }
+
+        begin = descending ? 0 : ended;
+
+        for (unsigned bucket = 0; bucket < values_in_byte; ++bucket)
+        {
+            const unsigned bucket_count = bucket_end[bucket] - begin;
+
+            if (bucket_count > 1 && begin != largest_begin)
+                radix_sort_string_impl(src + begin, bucket_count, bucket_cache + begin, depth + 1, descending);
+
+            begin = bucket_end[bucket];
+        }
+
+        src += largest_begin;
+        bucket_cache += largest_begin;
+        count = largest_count;
+        ++depth;
+    }
+
+    radix_sort_string_insertion_sort(src, count, depth, descending);
+}
+
+template <typename T>
+inline void radix_sort_string(T* src, const unsigned count, const radix_sort_order order)
+{
+    std::vector<uint16_t> bucket_cache(count);
+
+    radix_sort_string_impl(src, count, bucket_cache.data(), 0, order == radix_sort_order::descending);
+}
+
+// String versions: MSD radix sort by bytes, in lexicographic order
+// of unsigned bytes, with shorter keys before their extensions.
+// Extra memory is 2 bytes per key. Not stable.
+inline void radix_sort(std::string* src, unsigned count,
+                       radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_string(src, count, order);
+}
+
+#if __cplusplus >= 201703L
+inline void radix_sort(std::string_view* src, unsigned count,
+                       radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_string(src, count, order);
+}
+#endif
+
+inline void radix_sort(radix_sort_byte_key* src, unsigned count,
+                       radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_string(src, count, order);
+}
+
+// In-place versions: no buffer, O(1) extra memory, not stable.
+inline void radix_sort_in_place(uint8_t* src, unsigned count,
+                               radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort(src, count, order);
+}
+
+inline void radix_sort_in_place(int8_t* src, unsigned count,
+                               radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort(src, count, order);
+}
+
+inline void radix_sort_in_place(uint16_t* src, unsigned count,
+                               radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_in_place_ordered_impl(src, count, radix_sort_transform(), order);
+}
+
+inline void radix_sort_in_place(int16_t* src, unsigned count,
+                               radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_in_place_ordered_impl(src, count, radix_sort_transform(), order);
+}
+
+inline void radix_sort_in_place(uint32_t* src, unsigned count,
+                               radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_in_place_ordered_impl(src, count, radix_sort_transform(), order);
+}
+
+inline void radix_sort_in_place(int32_t* src, unsigned count,
+                               radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_in_place_ordered_impl(src, count, radix_sort_transform(), order);
+}
+
+inline void radix_sort_in_place(uint64_t* src, unsigned count,
+                               radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_in_place_ordered_impl(src, count, radix_sort_transform(), order);
+}
+
+inline void radix_sort_in_place(int64_t* src, unsigned count,
+                               radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_in_place_ordered_impl(src, count, radix_sort_transform(), order);
+}
+
+inline void radix_sort_in_place(float* src, unsigned count,
+                               radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_in_place_ordered_impl(src, count, radix_sort_transform(), order);
+}
+
+inline void radix_sort_in_place(double* src, unsigned count,
+                               radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_in_place_ordered_impl(src, count, radix_sort_transform(), order);
+}
+
+// Parallel versions. thread_count == 0 means std::thread::hardware_concurrency().
+// Small arrays are sorted with fewer threads, down to a single one.
+inline void radix_sort_parallel(uint16_t* src, unsigned count, uint16_t* temp, unsigned thread_count = 0,
+                                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_parallel_ordered_impl(src, count, temp, radix_sort_transform(), thread_count, order);
+}
+
+inline void radix_sort_parallel(int16_t* src, unsigned count, int16_t* temp, unsigned thread_count = 0,
+                                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_parallel_ordered_impl(src, count, temp, radix_sort_transform(), thread_count, order);
+}
+
+inline void radix_sort_parallel(uint32_t* src, unsigned count, uint32_t* temp, unsigned thread_count = 0,
+                                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_parallel_ordered_impl(src, count, temp, radix_sort_transform(), thread_count, order);
+}
+
+inline void radix_sort_parallel(int32_t* src, unsigned count, int32_t* temp, unsigned thread_count = 0,
+                                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_parallel_ordered_impl(src, count, temp, radix_sort_transform(), thread_count, order);
+}
+
+inline void radix_sort_parallel(uint64_t* src, unsigned count, uint64_t* temp, unsigned thread_count = 0,
+                                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_parallel_ordered_impl(src, count, temp, radix_sort_transform(), thread_count, order);
+}
+
+inline void radix_sort_parallel(int64_t* src, unsigned count, int64_t* temp, unsigned thread_count = 0,
+                                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_parallel_ordered_impl(src, count, temp, radix_sort_transform(), thread_count, order);
+}
+
+inline void radix_sort_parallel(float* src, unsigned count, float* temp, unsigned thread_count = 0,
+                                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_parallel_ordered_impl(src, count, temp, radix_sort_transform(), thread_count, order);
+}
+
+inline void radix_sort_parallel(double* src, unsigned count, double* temp, unsigned thread_count = 0,
+                                radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_parallel_ordered_impl(src, count, temp, radix_sort_transform(), thread_count, order);
+}
+
+// Selection versions, for every type radix_sort_transform takes,
+// no buffer and O(1) extra memory. k is an index into the sorted order.
+
+// Element k ends up where it would be after sorting, elements before it
+// are not greater, elements after it are not less (in the given order).
+template <typename T>
+inline void radix_nth_element(T* src, const unsigned count, const unsigned k,
+                              radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_select_ordered_impl(src, count, k, radix_sort_transform(), order);
+}
+
+// Moves the first k elements of the sorted order to the front, in no particular order.
+template <typename T>
+inline void radix_top_k(T* src, const unsigned count, const unsigned k,
+                        radix_sort_order order = radix_sort_order::ascending)
+{
+    if (k < count)
+        radix_select_ordered_impl(src, count, k, radix_sort_transform(), order);
+}
+
+// Same as radix_top_k, then sorts the first k elements. The rest is in no particular order.
+template <typename T>
+inline void radix_partial_sort(T* src, const unsigned count, unsigned k,
+                               radix_sort_order order = radix_sort_order::ascending)
+{
+    if (k > count)
+        k = count;
+
+    radix_top_k(src, count, k, order);
+    radix_sort_in_place_ordered_impl(src, k, radix_sort_transform(), order);
+}
+
+// Segmented versions: sort num_segments separate parts of data in one call,
+// segment s being data[segment_offsets[s]] .. data[segment_offsets[s + 1] - 1].
+// segment_offsets has num_segments + 1 entries and doesn't decrease.
+// For every type radix_sort_transform takes. Not stable.
+template <typename T>
+void radix_sort_segmented(T* data, const unsigned* segment_offsets, unsigned num_segments,
+                          radix_sort_workspace& workspace, radix_sort_order order = radix_sort_order::ascending)
+{
+    if (order == radix_sort_order::descending)
+        radix_sort_segments_impl(data, segment_offsets, 0, num_segments,
+                                 radix_sort_descending<radix_sort_transform>(radix_sort_transform()), workspace);
+    else
+        radix_sort_segments_impl(data, segment_offsets, 0, num_segments, radix_sort_transform(), workspace);
+}
+
+// Segments are spread across thread_count threads, 0 means hardware_concurrency().
+template <typename T>
+void radix_sort_segmented(T* data, const unsigned* segment_offsets, unsigned num_segments,
+                          unsigned thread_count = 1, radix_sort_order order = radix_sort_order::ascending)
+{
+    if (order == radix_sort_order::descending)
+        radix_sort_segmented_parallel_impl(data, segment_offsets, num_segments,
+                                           radix_sort_descending<radix_sort_transform>(radix_sort_transform()),
+                                           thread_count);
+    else
+        radix_sort_segmented_parallel_impl(data, segment_offsets, num_segments, radix_sort_transform(), thread_count);
+}
+
+// Workspace versions: the buffer and the histograms come from a
+// radix_sort_workspace, which can be reused by any number of sorts.
+inline void radix_sort(uint8_t* src, unsigned count, radix_sort_workspace&,
+                       radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort(src, count, order);
+}
+
+inline void radix_sort(int8_t* src, unsigned count, radix_sort_workspace&,
+                       radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort(src, count, order);
+}
+
+// Any other type radix_sort_transform takes.
+template <typename T>
+inline void radix_sort(T* src, unsigned count, radix_sort_workspace& workspace,
+                       radix_sort_order order = radix_sort_order::ascending)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "workspace sorts take trivially copyable types");
+
+    radix_sort_workspace_ordered_impl(src, count, workspace.buffer<T>(count), radix_sort_transform(),
+                                      workspace, order);
+}
+
+template <typename T>
+inline void radix_sort_parallel(T* src, unsigned count, radix_sort_workspace& workspace,
+                                unsigned thread_count = 0, radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_parallel(src, count, workspace.buffer<T>(count), thread_count, order);
+}
+
+template <typename T, typename KeyFn>
+inline void radix_sort_by_key(T* records, unsigned count, KeyFn key, radix_sort_workspace& workspace,
+                              radix_sort_order order = radix_sort_order::ascending)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "records sorted with a workspace must be trivially copyable, pass a buffer otherwise");
+
+    radix_sort_workspace_ordered_impl(records, count, workspace.buffer<T>(count),
+                                      radix_sort_key_transform<KeyFn>(key), workspace, order);
+}
+
+template <typename... T>
+struct radix_sort_all_trivially_copyable : std::true_type { };
+
+template <typename T, typename... Rest>
+struct radix_sort_all_trivially_copyable<T, Rest...>
+    : std::integral_constant<bool, std::is_trivially_copyable<T>::value &&
+                                   radix_sort_all_trivially_copyable<Rest...>::value> { };
+
+// Payload columns are plain pointers here, their buffers come from the workspace too.
+template <typename K, typename... P>
+void radix_sort_with_payload(K* keys, unsigned count, radix_sort_workspace& workspace, radix_sort_order order,
+                             P*... payload)
+{
+    static_assert(radix_sort_all_trivially_copyable<K, P...>::value,
+                  "payload sorted with a workspace must be trivially copyable, pass buffers otherwise");
+
+    const size_t column_bytes[] = { radix_sort_workspace::aligned_size(size_t(count) * sizeof(K)),
+                                    radix_sort_workspace::aligned_size(size_t(count) * sizeof(P))... };
+
+    size_t bytes = 0;
+
+    for (auto b : column_bytes)
+        bytes += b;
+
+    char* buffer = workspace.get(bytes);
+
+    radix_sort_workspace_payload_impl<sizeof...(P)>(keys, count, reinterpret_cast<K*>(buffer), radix_sort_transform(),
+                                                    workspace, order, buffer + column_bytes[0], payload...);
+}
+
+template <typename K, typename... P>
+void radix_sort_with_payload(K* keys, unsigned count, radix_sort_workspace& workspace, P*... payload)
+{
+    radix_sort_with_payload(keys, count, workspace, radix_sort_order::ascending, payload...);
+}
+
+// The bucket cache of the string sort comes from the workspace.
+inline void radix_sort(std::string* src, unsigned count, radix_sort_workspace& workspace,
+                       radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_string_impl(src, count, workspace.buffer<uint16_t>(count), 0,
+                           order == radix_sort_order::descending);
+}
+
+#if __cplusplus >= 201703L
+inline void radix_sort(std::string_view* src, unsigned count, radix_sort_workspace& workspace,
+                       radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_string_impl(src, count, workspace.buffer<uint16_t>(count), 0,
+                           order == radix_sort_order::descending);
+}
+#endif
+
+inline void radix_sort(radix_sort_byte_key* src, unsigned count, radix_sort_workspace& workspace,
+                       radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_string_impl(src, count, workspace.buffer<uint16_t>(count), 0,
+                           order == radix_sort_order::descending);
+}
+
+template <typename T>
+inline void radix_sort_merge_batch_impl(T* sorted, const size_t sorted_count, const T* batch,
+                                        const unsigned batch_count, radix_sort_order order)
+{
+    if (order == radix_sort_order::descending)
+        radix_sort_merge_in_place_impl(sorted, sorted_count, batch, batch_count,
+                                       radix_sort_descending<radix_sort_transform>(radix_sort_transform()));
+    else
+        radix_sort_merge_in_place_impl(sorted, sorted_count, batch, batch_count, radix_sort_transform());
+}
+
+template <typename T>
+inline void radix_sort_merge_batch_impl(const T* sorted, const size_t sorted_count, const T* batch,
+                                        const unsigned batch_count, T* dst, radix_sort_order order)
+{
+    if (order == radix_sort_order::descending)
+        radix_sort_merge_to_impl(sorted, sorted_count, batch, batch_count, dst,
+                                 radix_sort_descending<radix_sort_transform>(radix_sort_transform()));
+    else
+        radix_sort_merge_to_impl(sorted, sorted_count, batch, batch_count, dst, radix_sort_transform());
+}
+
+// Incremental versions, for a sorted array that grows by batches.
+// The batch is radix sorted (it's left sorted) and merged into the array,
+// so a batch costs one sort of the batch and one merge pass over the part
+// of the array after the smallest batch element; a batch much smaller than
+// the array is merged with galloping. sorted must have room for
+// sorted_count + batch_count elements. Stable: on equal keys the array
+// elements stay before the batch ones. Types radix_sort takes a buffer for.
+template <typename T>
+void radix_sort_merge_batch(T* sorted, size_t sorted_count, T* batch, unsigned batch_count, T* temp,
+                            radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort(batch, batch_count, temp, order);
+    radix_sort_merge_batch_impl(sorted, sorted_count, batch, batch_count, order);
+}
+
+template <typename T>
+void radix_sort_merge_batch(T* sorted, size_t sorted_count, T* batch, unsigned batch_count,
+                            radix_sort_workspace& workspace, radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort(batch, batch_count, workspace, order);
+    radix_sort_merge_batch_impl(sorted, sorted_count, batch, batch_count, order);
+}
+
+// The array is left as it is, the result goes to dst
+// (sorted_count + batch_count elements).
+template <typename T>
+void radix_sort_merge_batch(const T* sorted, size_t sorted_count, T* batch, unsigned batch_count, T* temp, T* dst,
+                            radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort(batch, batch_count, temp, order);
+    radix_sort_merge_batch_impl(sorted, sorted_count, batch, batch_count, dst, order);
+}
+
+template <typename T>
+void radix_sort_merge_batch(const T* sorted, size_t sorted_count, T* batch, unsigned batch_count,
+                            radix_sort_workspace& workspace, T* dst,
+                            radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort(batch, batch_count, workspace, order);
+    radix_sort_merge_batch_impl(sorted, sorted_count, batch, batch_count, dst, order);
+}
+
+// Sort + unique: sorts src and leaves one element of every run of equal
+// keys at the front, like std::sort followed by std::unique but without the
+// extra pass (the repeats are dropped in the last reordering pass).
+// Returns the number of distinct keys. Keys are compared as radix_sort
+// orders them, so -0.0 and 0.0 are different keys.
+// radix_sort_counts also writes the number of occurrences of every distinct
+// key to counts, which must have room for count values.
+// 8 bit versions take the result straight from the histogram.
+template <typename T>
+unsigned radix_sort_counts_8_impl(T* src, const unsigned count, unsigned* counts, radix_sort_order order)
+{
+    const unsigned sign = std::is_signed<T>::value ? 0x80 : 0;
+
+    unsigned histogram[values_in_byte] = { 0 };
+
+    for (unsigned i = 0; i < count; ++i)
+        ++histogram[uint8_t(src[i]) ^ sign];
+
+    unsigned distinct = 0;
+
+    for (unsigned bucket = 0; bucket < values_in_byte; ++bucket)
+    {
+        const unsigned key = order == radix_sort_order::descending ? lsb_mask - bucket : bucket;
+
+        if (!histogram[key])
+            continue;
+
+        src[distinct] = T(uint8_t(key ^ sign));
+
+        if (counts)
+            counts[distinct] = histogram[key];
+
+        ++distinct;
+    }
+
+    return distinct;
+}
+
+inline unsigned radix_sort_unique(uint8_t* src, unsigned count, radix_sort_order order = radix_sort_order::ascending)
+{
+    return radix_sort_counts_8_impl(src, count, nullptr, order);
+}
+
+inline unsigned radix_sort_unique(int8_t* src, unsigned count, radix_sort_order order = radix_sort_order::ascending)
+{
+    return radix_sort_counts_8_impl(src, count, nullptr, order);
+}
+
+inline unsigned radix_sort_counts(uint8_t* src, unsigned count, unsigned* counts,
+                                  radix_sort_order order = radix_sort_order::ascending)
+{
+    return radix_sort_counts_8_impl(src, count, counts, order);
+}
+
+inline unsigned radix_sort_counts(int8_t* src, unsigned count, unsigned* counts,
+                                  radix_sort_order order = radix_sort_order::ascending)
+{
+    return radix_sort_counts_8_impl(src, count, counts, order);
+}
+
+template <typename T>
+inline unsigned radix_sort_unique_ordered_impl(T* src, unsigned count, T* temp, unsigned* counts,
+                                               radix_sort_order order)
+{
+    if (order == radix_sort_order::descending)
+        return radix_sort_unique_impl<RADIX_SORT_DIGIT_BITS>(src, count, temp,
+            radix_sort_descending<radix_sort_transform>(radix_sort_transform()), counts);
+
+    return radix_sort_unique_impl<RADIX_SORT_DIGIT_BITS>(src, count, temp, radix_sort_transform(), counts);
+}
+
+// Any other type radix_sort_transform takes.
+template <typename T>
+unsigned radix_sort_unique(T* src, unsigned count, T* temp, radix_sort_order order = radix_sort_order::ascending)
+{
+    return radix_sort_unique_ordered_impl(src, count, temp, nullptr, order);
+}
+
+template <typename T>
+unsigned radix_sort_counts(T* src, unsigned count, T* temp, unsigned* counts,
+                           radix_sort_order order = radix_sort_order::ascending)
+{
+    return radix_sort_unique_ordered_impl(src, count, temp, counts, order);
+}
+
+template <typename T>
+unsigned radix_sort_unique(T* src, const unsigned count, radix_sort_order order = radix_sort_order::ascending)
+{
+    T * temp = new T[count];
+    const unsigned distinct = radix_sort_unique(src, count, temp, order);
+    delete[] temp;
+
+    return distinct;
+}
+
+template <typename T>
+unsigned radix_sort_counts(T* src, const unsigned count, unsigned* counts,
+                           radix_sort_order order = radix_sort_order::ascending)
+{
+    T * temp = new T[count];
+    const unsigned distinct = radix_sort_counts(src, count, temp, counts, order);
+    delete[] temp;
+
+    return distinct;
+}
+
+template <typename T>
+void radix_sort(T* src, const unsigned count, radix_sort_order order = radix_sort_order::ascending)
+{
+    T * temp = new T[count];
+    radix_sort(src, count, temp, order);
+    delete[] temp;
+}
+
+template <typename T>
+void radix_sort_parallel(T* src, const unsigned count, const unsigned thread_count = 0,
+                         radix_sort_order order = radix_sort_order::ascending)
+{
+    T * temp = new T[count];
+    radix_sort_parallel(src, count, temp, thread_count, order);
+    delete[] temp;
+}
+
+template <typename T, typename KeyFn>
+void radix_sort_by_key(T* records, const unsigned count, KeyFn key,
+                       radix_sort_order order = radix_sort_order::ascending)
+{
+    T * temp = new T[count];
+    radix_sort_by_key(records, count, key, temp, order);
+    delete[] temp;
+}
+
+// Streaming version, for data that arrives in chunks. The histograms of all
+// digits are counted as every chunk is added, while it's still in the cache,
+// so finish() starts with the offset table and goes straight to the
+// reordering passes instead of reading the whole array once more.
+// A chunk is either copied in with append, or written in place: prepare(n)
+// gives room for n elements at the end, commit(m) counts the first m of them
+// (m <= n) and drops the rest. The data is sorted by finish(), after which
+// data() holds the result until clear() starts over. finish() again does
+// nothing, a chunk added after it counts the sorted data once more and goes
+// to the next finish() together with it. Keys are elements of
+// any type radix_sort_transform takes, or trivially copyable records with
+// a radix_sort_key_transform. Stable.
+template <typename T, typename F = radix_sort_transform>
+class radix_sort_builder
+{
+    static_assert(std::is_trivially_copyable<T>::value, "the builder sorts trivially copyable types only");
+
+public:
+
+    explicit radix_sort_builder(radix_sort_order order = radix_sort_order::ascending,
+                                F bitwise_transform = F())
+        : order(order), bitwise_transform(bitwise_transform), histograms(histogram_size, 0), descents(0),
+          prepared(0), finished(false) { }
+
+    radix_sort_builder(const radix_sort_builder&) = delete;
+    radix_sort_builder& operator=(const radix_sort_builder&) = delete;
+
+    void reserve(const unsigned count)
+    {
+        elements.reserve(count);
+    }
+
+    void append(const T* chunk, const unsigned count)
+    {
+        const unsigned size = unsigned(elements.size());
+
+        elements.insert(elements.end(), chunk, chunk + count);
+        count_chunk(size, count);
+    }
+
+    T* prepare(const unsigned count)
+    {
+        prepared = unsigned(elements.size());
+        elements.resize(prepared + size_t(count));
+
+        return elements.data() + prepared;
+    }
+
+    void commit(const unsigned count)
+    {
+        elements.resize(prepared + size_t(count));
+        count_chunk(prepared, count);
+    }
+
+    T* finish()
+    {
+        if (finished)
+            return elements.data();
+
+        const unsigned count = unsigned(elements.size());
+
+        if (order == radix_sort_order::descending)
+            finish(count, radix_sort_descending<F>(bitwise_transform));
+        else
+            finish(count, bitwise_transform);
+
+        // The sort turned the histograms into offset tables.
+        std::fill(histograms.begin(), histograms.end(), 0U);
+        descents = 0;
+        finished = true;
+
+        return elements.data();
+    }
+
+    void clear()
+    {
+        elements.clear();
+        std::fill(histograms.begin(), histograms.end(), 0U);
+        descents = 0;
+        finished = false;
+    }
+
+    T* data() { return elements.data(); }
+    unsigned size() const { return unsigned(elements.size()); }
+
+private:
+
+    typedef decltype(std::declval<F>()(std::declval<const T&>())) key_type;
+
+    static const unsigned histogram_size = radix_sort_histogram_size<RADIX_SORT_DIGIT_BITS, sizeof(key_type)>::value;
+
+    radix_sort_order order;
+    F bitwise_transform;
+
+    std::vector<T> elements;
+    std::vector<unsigned> histograms;
+    unsigned descents;
+    unsigned prepared;
+    bool finished;
+
+    radix_sort_workspace workspace;
+
+    // Counts elements first .. first + count - 1, a descent between the
+    // previous chunk and this one included. After finish() the elements
+    // before first aren't counted any more, they are counted again first.
+    void count_chunk(const unsigned first, const unsigned count)
+    {
+        if (finished && count)
+        {
+            finished = false;
+            count_chunk(0, first);
+        }
+
+        if (order == radix_sort_order::descending)
+            count_chunk(first, count, radix_sort_descending<F>(bitwise_transform));
+        else
+            count_chunk(first, count, bitwise_transform);
+    }
+
+    template <typename G>
+    void count_chunk(const unsigned first, const unsigned count, G transform)
+    {
+        if (!count)
+            return;
+
+        const T* chunk = elements.data() + first;
+
+        if (first)
+            descents += transform(chunk[0]) < transform(chunk[-1]);
+
+        descents += count >= radix_sort_split_histograms_threshold
+            ? radix_sort_count_digits<radix_sort_can_split_histograms<histogram_size>::value, RADIX_SORT_DIGIT_BITS>(
+                  chunk, count, histograms.data(), transform)
+            : radix_sort_count_digits<false, RADIX_SORT_DIGIT_BITS>(chunk, count, histograms.data(), transform);
+    }
+
+    template <typename G>
+    void finish(const unsigned count, G transform)
+    {
+        radix_sort_null_observer observer;
+
+        radix_sort_lsd_counted<RADIX_SORT_DIGIT_BITS>(elements.data(), count, workspace.buffer<T>(count), transform,
+                                                      observer, histograms.data(), descents);
+    }
+};
+
+// Generic front end: iterators, containers, arrays and spans.
+
+// The type radix_sort takes for elements of type T, void if there is none.
+// Integers of every type are keyed as the fixed width type of the same size
+// and signedness, so int, long, long long, char etc. all take the fast path.
+template <typename T, bool is_integer = std::is_integral<T>::value &&
+                                        !std::is_same<T, bool>::value && sizeof(T) <= 8>
+struct radix_sort_element_type
+{
+    typedef void type;
+};
+
+template <typename T>
+struct radix_sort_element_type<T, true>
+{
+    typedef typename radix_sort_integer<sizeof(T), std::is_signed<T>::value>::type type;
+};
+
+template <> struct radix_sort_element_type<float, false> { typedef float type; };
+template <> struct radix_sort_element_type<double, false> { typedef double type; };
+template <> struct radix_sort_element_type<std::string, false> { typedef std::string type; };
+#if __cplusplus >= 201703L
+template <> struct radix_sort_element_type<std::string_view, false> { typedef std::string_view type; };
+#endif
+template <> struct radix_sort_element_type<radix_sort_byte_key, false> { typedef radix_sort_byte_key type; };
+#ifdef __SIZEOF_INT128__
+template <> struct radix_sort_element_type<unsigned __int128, false> { typedef unsigned __int128 type; };
+template <> struct radix_sort_element_type<__int128, false> { typedef __int128 type; };
+#endif
+
+// Pairs and tuples of numbers, byte arrays.
+template <typename T>
+struct radix_sort_is_component
+{
+    typedef typename radix_sort_element_type<T>::type element_type;
+
+#ifdef __SIZEOF_INT128__
+    static const bool value = std::is_arithmetic<element_type>::value ||
+                              std::is_same<element_type, unsigned __int128>::value ||
+                              std::is_same<element_type, __int128>::value;
+#else
+    static const bool value = std::is_arithmetic<element_type>::value;
+#endif
+};
+
+template <typename... E>
+struct radix_sort_are_components;
+
+template <>
+struct radix_sort_are_components<>
+{
+    static const bool value = true;
+};
+
+template <typename T, typename... E>
+struct radix_sort_are_components<T, E...>
+{
+    static const bool value = radix_sort_is_component<T>::value && radix_sort_are_components<E...>::value;
+};
+
+template <typename A, typename B>
+struct radix_sort_element_type<std::pair<A, B>, false>
+{
+    typedef typename std::conditional<radix_sort_are_components<A, B>::value, std::pair<A, B>, void>::type type;
+};
+
+template <typename... E>
+struct radix_sort_element_type<std::tuple<E...>, false>
+{
+    typedef typename std::conditional<sizeof...(E) != 0 && radix_sort_are_components<E...>::value,
+                                      std::tuple<E...>, void>::type type;
+};
+
+template <size_t N>
+struct radix_sort_element_type<std::array<unsigned char, N>, false>
+{
+    typedef typename std::conditional<N != 0, std::array<unsigned char, N>, void>::type type;
+};
+
+template <size_t N>
+struct radix_sort_element_type<std::array<char, N>, false>
+{
+    typedef typename std::conditional<N != 0, std::array<char, N>, void>::type type;
+};
+
+// Iterators whose elements are consecutive in memory: pointers and
+// std::vector iterators, every std::contiguous_iterator with C++20.
+template <typename It>
+struct radix_sort_is_contiguous_iterator
+{
+    typedef typename std::iterator_traits<It>::value_type value_type;
+
+#if __cplusplus >= 202002L && defined(__cpp_lib_concepts)
+    static const bool value = std::contiguous_iterator<It>;
+#else
+    static const bool value = std::is_pointer<It>::value ||
+        (!std::is_same<value_type, bool>::value &&
+         std::is_same<It, typename std::vector<value_type>::iterator>::value);
+#endif
+};
+
+template <typename It>
+struct radix_sort_front_end_supported
+{
+    typedef typename std::iterator_traits<It>::value_type value_type;
+
+    static const bool value = radix_sort_is_contiguous_iterator<It>::value &&
+        !std::is_void<typename radix_sort_element_type<value_type>::type>::value &&
+        !std::is_const<typename std::remove_reference<typename std::iterator_traits<It>::reference>::type>::value;
+};
+
+template <typename T>
+inline void radix_sort_front_end_call(T* src, unsigned count, radix_sort_order order, bool parallel)
+{
+    if (parallel)
+        radix_sort_parallel(src, count, 0, order);
+    else
+        radix_sort(src, count, order);
+}
+
+// 8 bit integers and strings have no parallel version.
+inline void radix_sort_front_end_call(uint8_t* src, unsigned count, radix_sort_order order, bool)
+{
+    radix_sort(src, count, order);
+}
+
+inline void radix_sort_front_end_call(int8_t* src, unsigned count, radix_sort_order order, bool)
+{
+    radix_sort(src, count, order);
+}
+
+inline void radix_sort_front_end_call(std::string* src, unsigned count, radix_sort_order order, bool)
+{
+    radix_sort(src, count, order);
+}
+
+#if __cplusplus >= 201703L
+inline void radix_sort_front_end_call(std::string_view* src, unsigned count, radix_sort_order order, bool)
+{
+    radix_sort(src, count, order);
+}
+#endif
+
+inline void radix_sort_front_end_call(radix_sort_byte_key* src, unsigned count, radix_sort_order order, bool)
+{
+    radix_sort(src, count, order);
+}
+
+// Neither have 128 bit and composite keys.
+#ifdef __SIZEOF_INT128__
+inline void radix_sort_front_end_call(unsigned __int128* src, unsigned count, radix_sort_order order, bool)
+{
+    radix_sort(src, count, order);
+}
+
+inline void radix_sort_front_end_call(__int128* src, unsigned count, radix_sort_order order, bool)
+{
+    radix_sort(src, count, order);
+}
+#endif
+
+template <typename A, typename B>
+inline void radix_sort_front_end_call(std::pair<A, B>* src, unsigned count, radix_sort_order order, bool)
+{
+    radix_sort(src, count, order);
+}
+
+template <typename... E>
+inline void radix_sort_front_end_call(std::tuple<E...>* src, unsigned count, radix_sort_order order, bool)
+{
+    radix_sort(src, count, order);
+}
+
+template <typename B, size_t N>
+inline void radix_sort_front_end_call(std::array<B, N>* src, unsigned count, radix_sort_order order, bool)
+{
+    radix_sort(src, count, order);
+}
+
+// Integers of a type that is none of the fixed width types (long long where
+// int64_t is long, char) are sorted as they are, by their value converted to
+// the fixed width type E. Accessing them through an E* would break strict
+// aliasing.
+template <typename E>
+struct radix_sort_converting_transform
+{
+    template <typename T>
+    auto operator()(const T value) const -> decltype(radix_sort_transform()(E(value)))
+    {
+        return radix_sort_transform()(E(value));
+    }
+};
+
+template <typename T>
+inline void radix_sort_front_end_convert(T* src, unsigned count, radix_sort_order order, bool parallel)
+{
+    typedef typename radix_sort_element_type<T>::type element_type;
+
+    const radix_sort_converting_transform<element_type> transform;
+
+    T * temp = new T[count];
+
+    if (parallel)
+        radix_sort_parallel_ordered_impl(src, count, temp, transform, 0, order);
+    else
+        radix_sort_ordered_impl(src, count, temp, transform, order);
+
+    delete[] temp;
+}
+
+template <typename T>
+inline void radix_sort_front_end_dispatch(std::true_type, T* src, unsigned count, radix_sort_order order,
+                                          bool parallel)
+{
+    radix_sort_front_end_call(src, count, order, parallel);
+}
+
+template <typename T>
+inline void radix_sort_front_end_dispatch(std::false_type, T* src, unsigned count, radix_sort_order order,
+                                          bool parallel)
+{
+    radix_sort_front_end_convert(src, count, order, parallel);
+}
+
+template <typename It, typename Fallback>
+inline void radix_sort_front_end(std::false_type, It, It, radix_sort_order, bool, Fallback fallback)
+{
+    fallback();
+}
+
+template <typename It, typename Fallback>
+inline void radix_sort_front_end(std::true_type, It first, It last, radix_sort_order order, bool parallel,
+                                 Fallback fallback)
+{
+    typedef typename std::iterator_traits<It>::value_type value_type;
+    typedef typename radix_sort_element_type<value_type>::type element_type;
+
+    const size_t count = size_t(last - first);
+
+    if (!count)
+        return;
+
+    // radix_sort counts are unsigned
+    if (count > UINT_MAX)
+    {
+        fallback();
+        return;
+    }
+
+    value_type* src = &*first;
+
+    radix_sort_front_end_dispatch(std::integral_constant<bool, std::is_same<value_type, element_type>::value>(),
+                                  src, unsigned(count), order, parallel);
+}
+
+template <typename It>
+inline void radix_sort_std_sort(It first, It last, radix_sort_order order)
+{
+    typedef typename std::iterator_traits<It>::value_type value_type;
+
+    if (order == radix_sort_order::descending)
+        std::sort(first, last, [](const value_type& a, const value_type& b) { return b < a; });
+    else
+        std::sort(first, last);
+}
+
+// Sorts [first, last). Contiguous iterators over integers, floats, doubles
+// and strings go to radix_sort, everything else to std::sort.
+template <typename It>
+inline typename std::enable_if<!std::is_void<typename std::iterator_traits<It>::value_type>::value>::type
+radix_sort(It first, It last, radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_front_end(std::integral_constant<bool, radix_sort_front_end_supported<It>::value>(),
+                         first, last, order, false,
+                         [&] { radix_sort_std_sort(first, last, order); });
+}
+
+template <typename It>
+inline typename std::enable_if<!std::is_void<typename std::iterator_traits<It>::value_type>::value>::type
+radix_sort_parallel(It first, It last, radix_sort_order order = radix_sort_order::ascending)
+{
+    radix_sort_front_end(std::integral_constant<bool, radix_sort_front_end_supported<It>::value>(),
+                         first, last, order, true,
+                         [&] { radix_sort_std_sort(first, last, order); });
+}
+
+// Sorts a whole container, built-in array or std::span.
+template <typename R>
+inline auto radix_sort(R&& range, radix_sort_order order = radix_sort_order::ascending)
+    -> decltype(std::begin(range), std::end(range), void())
+{
+    radix_sort(std::begin(range), std::end(range), order);
+}
+
+template <typename R>
+inline auto radix_sort_parallel(R&& range, radix_sort_order order = radix_sort_order::ascending)
+    -> decltype(std::begin(range), std::end(range), void())
+{
+    radix_sort_parallel(std::begin(range), std::end(range), order);
 }
 
-#endif //RADIX_SORT_H
+#endif //RADIX_SORT_H
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "radix_sort.hpp"
+
+#include <execution>
+
+#ifndef RADIX_SORT_EXECUTION_H
+#define RADIX_SORT_EXECUTION_H
+
+/*
+    Execution policy front end (C++17), a drop-in for
+    std::sort(policy, first, last).
+
+    radix_sort(policy, first, last, order) and radix_sort(policy, range, order)
+    sort with radix_sort_parallel for std::execution::par and par_unseq, and
+    with the sequential radix_sort for seq and unseq. Types and iterators
+    radix_sort doesn't take are sorted with std::sort and the same policy.
+
+    It's a separate header because <execution> in libstdc++ needs TBB
+    (-ltbb) for the parallel std algorithms.
+*/
+
+template <typename Policy>
+struct radix_sort_is_parallel_policy
+{
+    typedef typename std::decay<Policy>::type policy_type;
+
+    static const bool value = std::is_same<policy_type, std::execution::parallel_policy>::value ||
+                              std::is_same<policy_type, std::execution::parallel_unsequenced_policy>::value;
+};
+
+template <typename Policy, typename It>
+inline typename std::enable_if<std::is_execution_policy<typename std::decay<Policy>::type>::value>::type
+radix_sort(Policy&& policy, It first, It last, radix_sort_order order = radix_sort_order::ascending)
+{
+    typedef typename std::iterator_traits<It>::value_type value_type;
+
+    radix_sort_front_end(std::integral_constant<bool, radix_sort_front_end_supported<It>::value>(),
+                         first, last, order, radix_sort_is_parallel_policy<Policy>::value,
+                         [&]
+                         {
+                             if (order == radix_sort_order::descending)
+                                 std::sort(policy, first, last,
+                                           [](const value_type& a, const value_type& b) { return b < a; });
+                             else
+                                 std::sort(policy, first, last);
+                         });
+}
+
+template <typename Policy, typename R>
+inline auto radix_sort(Policy&& policy, R&& range, radix_sort_order order = radix_sort_order::ascending)
+    -> typename std::enable_if<std::is_execution_policy<typename std::decay<Policy>::type>::value,
+                               decltype(std::begin(range), std::end(range), void())>::type
+{
+    radix_sort(std::forward<Policy>(policy), std::begin(range), std::end(range), order);
+}
+
+#endif //RADIX_SORT_EXECUTION_H
@@ -0,0 +1,279 @@
+#include "radix_sort.hpp"
+
+#include <cstdio>
+#include <cstddef>
+#include <string>
+#include <queue>
+#include <functional>
+#include <random>
+
+#ifndef RADIX_SORT_EXTERNAL_H
+#define RADIX_SORT_EXTERNAL_H
+
+/*
+    External memory radix sort, for binary files larger than RAM.
+
+    radix_sort_file<T>(input, output, memory_budget, temp_dir, order) sorts a
+    file of raw T values (any type radix_sort takes a buffer for, pairs,
+    tuples and byte arrays included) into output. The input is read in
+    chunks, every chunk is sorted with radix_sort and written out as a
+    sorted run; reading of the next chunk overlaps with sorting of the
+    current one. Then all runs are merged with a k-way merge, in the order
+    of radix_sort_less, reading and writing in large sequential blocks.
+
+    memory_budget is the number of bytes the sort may use for data.
+    Runs are created in temp_dir, or next to output if temp_dir is null,
+    under names no other sort uses, and are removed afterwards. Returns
+    false on any I/O error and if the size of input isn't a multiple of
+    sizeof(T).
+*/
+
+struct radix_sort_file_closer
+{
+    std::FILE* file;
+
+    explicit radix_sort_file_closer(std::FILE* file) : file(file) { }
+
+    ~radix_sort_file_closer()
+    {
+        if (file)
+            std::fclose(file);
+    }
+
+    // Closes the file now; false if the data couldn't be written out.
+    bool close()
+    {
+        std::FILE* closing = file;
+        file = nullptr;
+
+        return std::fclose(closing) == 0;
+    }
+};
+
+// Run files get a random name and are created exclusively (fopen "x"), with
+// another name if one exists, so that sorts sharing a temp_dir don't write
+// into each other's runs. Returns null if no run file can be created.
+inline std::FILE* radix_sort_create_run(const char* output_path, const char* temp_dir, std::string& path)
+{
+    std::random_device random;
+
+    const unsigned attempts = 16;
+
+    for (unsigned attempt = 0; attempt < attempts; ++attempt)
+    {
+        const uint64_t id = (uint64_t(random()) << 32) ^ random();
+
+        path = temp_dir ? std::string(temp_dir) + "/radix_sort" : std::string(output_path);
+        path += "." + std::to_string(id) + ".run";
+
+        if (std::FILE* run = std::fopen(path.c_str(), "wbx"))
+            return run;
+    }
+
+    return nullptr;
+}
+
+// Reads up to count values into data, read gets the number of values read.
+// false on an error, or if the file ends in the middle of a value.
+template <typename T>
+bool radix_sort_read_chunk(std::FILE* input, T* data, const size_t count, size_t& read)
+{
+    const size_t bytes = std::fread(data, 1, count * sizeof(T), input);
+
+    read = bytes / sizeof(T);
+
+    return bytes % sizeof(T) == 0 && !std::ferror(input);
+}
+
+inline void radix_sort_remove_runs(const std::vector<std::string>& run_paths)
+{
+    for (const auto& path : run_paths)
+        std::remove(path.c_str());
+}
+
+// Merges sorted runs into output. Every run gets its own read block of
+// block_elements values, the output gets one as well.
+template <typename T, typename Less>
+bool radix_sort_merge_runs(const std::vector<std::string>& run_paths, std::FILE* output,
+                           const size_t block_elements, Less less)
+{
+    // (value, run), ties go to the earlier run, which keeps the merge stable.
+    typedef std::pair<T, size_t> head_type;
+
+    auto later = [&](const head_type& a, const head_type& b)
+    {
+        return less(b.first, a.first) || (!less(a.first, b.first) && a.second > b.second);
+    };
+
+    const size_t run_count = run_paths.size();
+
+    std::vector<std::FILE*> runs(run_count, nullptr);
+    std::vector<T> blocks((run_count + 1) * block_elements);
+    std::vector<size_t> block_size(run_count, 0);
+    std::vector<size_t> block_position(run_count, 0);
+
+    T* out_block = &blocks[run_count * block_elements];
+    size_t out_size = 0;
+
+    bool ok = true;
+
+    std::priority_queue<head_type, std::vector<head_type>, decltype(later)> heads(later);
+
+    auto refill = [&](size_t run) -> bool
+    {
+        block_size[run] = std::fread(&blocks[run * block_elements], sizeof(T), block_elements, runs[run]);
+        block_position[run] = 0;
+
+        if (block_size[run] < block_elements && std::ferror(runs[run]))
+            ok = false;
+
+        return block_size[run] != 0;
+    };
+
+    for (size_t run = 0; run < run_count && ok; ++run)
+    {
+        runs[run] = std::fopen(run_paths[run].c_str(), "rb");
+
+        if (!runs[run])
+            ok = false;
+        else if (refill(run))
+            heads.push(head_type(blocks[run * block_elements], run));
+    }
+
+    while (!heads.empty() && ok)
+    {
+        const size_t run = heads.top().second;
+        heads.pop();
+
+        out_block[out_size++] = blocks[run * block_elements + block_position[run]++];
+
+        if (out_size == block_elements)
+        {
+            ok = std::fwrite(out_block, sizeof(T), out_size, output) == out_size;
+            out_size = 0;
+        }
+
+        if (block_position[run] != block_size[run] || refill(run))
+            heads.push(head_type(blocks[run * block_elements + block_position[run]], run));
+    }
+
+    if (ok && out_size)
+        ok = std::fwrite(out_block, sizeof(T), out_size, output) == out_size;
+
+    for (auto run : runs)
+        if (run)
+            std::fclose(run);
+
+    return ok;
+}
+
+template <typename T>
+bool radix_sort_file(const char* input_path, const char* output_path, size_t memory_budget,
+                     const char* temp_dir = nullptr, radix_sort_order order = radix_sort_order::ascending)
+{
+    // The chunk being sorted, its radix_sort buffer and the chunk being read.
+    size_t chunk_elements = memory_budget / (3 * sizeof(T));
+
+    if (chunk_elements > UINT_MAX)
+        chunk_elements = UINT_MAX;
+
+    if (!chunk_elements)
+        return false;
+
+    std::FILE* input = std::fopen(input_path, "rb");
+
+    if (!input)
+        return false;
+
+    radix_sort_file_closer input_closer(input);
+
+    std::vector<T> current(chunk_elements);
+    std::vector<T> next(chunk_elements);
+    std::vector<T> temp(chunk_elements);
+
+    size_t current_size = 0;
+    size_t next_size = 0;
+
+    bool read_ok = radix_sort_read_chunk(input, current.data(), chunk_elements, current_size);
+
+    std::vector<std::string> run_paths;
+
+    while (current_size && read_ok)
+    {
+        std::thread reader([&]
+        {
+            read_ok = radix_sort_read_chunk(input, next.data(), chunk_elements, next_size);
+        });
+
+        radix_sort(current.data(), unsigned(current_size), temp.data(), order);
+
+        reader.join();
+
+        if (!read_ok)
+            break;
+
+        // The whole input fits into one chunk, no runs and no merge needed.
+        const bool last_chunk = run_paths.empty() && !next_size;
+
+        std::string path = output_path;
+
+        std::FILE* run = last_chunk ? std::fopen(output_path, "wb")
+                                    : radix_sort_create_run(output_path, temp_dir, path);
+
+        if (!run)
+            break;
+
+        radix_sort_file_closer run_closer(run);
+
+        if (!last_chunk)
+            run_paths.push_back(path);
+
+        if (std::fwrite(current.data(), sizeof(T), current_size, run) != current_size || !run_closer.close())
+            break;
+
+        if (last_chunk)
+            return true;
+
+        current.swap(next);
+        current_size = next_size;
+    }
+
+    if (current_size || !read_ok)
+    {
+        radix_sort_remove_runs(run_paths);
+        return false;
+    }
+
+    std::FILE* output = std::fopen(output_path, "wb");
+
+    if (!output)
+    {
+        radix_sort_remove_runs(run_paths);
+        return false;
+    }
+
+    radix_sort_file_closer output_closer(output);
+
+    // The sort buffers aren't needed anymore, the merge reuses the whole budget.
+    std::vector<T>().swap(current);
+    std::vector<T>().swap(next);
+    std::vector<T>().swap(temp);
+
+    const size_t min_block_elements = (size_t(1) << 16) / sizeof(T);
+
+    size_t block_elements = memory_budget / ((run_paths.size() + 1) * sizeof(T));
+
+    if (block_elements < min_block_elements)
+        block_elements = min_block_elements;
+
+    bool ok = radix_sort_merge_runs<T>(run_paths, output, block_elements,
+                                       radix_sort_less(static_cast<const T*>(nullptr), order));
+
+    ok = output_closer.close() && ok;
+
+    radix_sort_remove_runs(run_paths);
+
+    return ok;
+}
+
+#endif //RADIX_SORT_EXTERNAL_H
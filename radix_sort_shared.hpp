@@ -0,0 +1,112 @@
+#include "radix_sort.hpp"
+
+#include <pthread.h>
+
+#ifndef RADIX_SORT_SHARED_H
+#define RADIX_SORT_SHARED_H
+
+/*
+    Multi-process radix sort over shared memory (POSIX).
+
+    process_count processes sort one array together: each of them calls
+    radix_sort_shared(src, count, dst, control, rank, order) with its own
+    rank, 0 .. process_count - 1. src, dst (count elements each) and the
+    control block must be in memory shared by all the processes (shm_open
+    and mmap, or an anonymous shared mapping inherited through fork); each
+    process may map them at its own address.
+
+    For every digit each process counts its slice of src into its own
+    histogram in the control block and waits at a process-shared barrier.
+    Then every process turns the histograms of all slices into the same
+    offset table, scatters its slice into its own slots of dst and waits
+    again: each process runs radix_sort_parallel_slice on its own slice.
+    Like radix_sort_parallel it's stable, and the result is in src.
+
+    The control block takes radix_sort_shared_control_size(process_count)
+    bytes. It is set up once with radix_sort_shared_init before any process
+    starts sorting and serves any number of sorts by the same processes.
+    If a process dies during a sort, the others wait forever.
+*/
+
+struct radix_sort_shared_control
+{
+    pthread_barrier_t barrier;
+    unsigned process_count;
+};
+
+const unsigned radix_sort_shared_buckets = radix_sort_digit<RADIX_SORT_DIGIT_BITS>::buckets;
+
+// The histograms follow the control block, the two sets of
+// process_count * buckets radix_sort_parallel_slice takes.
+inline size_t radix_sort_shared_control_size(const unsigned process_count)
+{
+    return sizeof(radix_sort_shared_control) +
+           2 * size_t(process_count) * radix_sort_shared_buckets * sizeof(unsigned);
+}
+
+// Returns null if the barrier can't be made.
+inline radix_sort_shared_control* radix_sort_shared_init(void* memory, const unsigned process_count)
+{
+    radix_sort_shared_control* control = new (memory) radix_sort_shared_control;
+
+    control->process_count = process_count;
+
+    pthread_barrierattr_t attributes;
+
+    if (pthread_barrierattr_init(&attributes) != 0)
+        return nullptr;
+
+    const bool ok = pthread_barrierattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED) == 0 &&
+                    pthread_barrier_init(&control->barrier, &attributes, process_count) == 0;
+
+    pthread_barrierattr_destroy(&attributes);
+
+    return ok ? control : nullptr;
+}
+
+// Once all the processes are done with the control block.
+inline void radix_sort_shared_destroy(radix_sort_shared_control* control)
+{
+    pthread_barrier_destroy(&control->barrier);
+}
+
+// The process-shared barrier in the shape radix_sort_parallel_slice waits on.
+struct radix_sort_shared_barrier
+{
+    pthread_barrier_t* barrier;
+
+    void wait()
+    {
+        pthread_barrier_wait(barrier);
+    }
+};
+
+template <unsigned radix_bits, typename T, typename F>
+void radix_sort_shared_impl(T* src, const unsigned count, T* dst, F bitwise_transform,
+                            radix_sort_shared_control* control, const unsigned rank)
+{
+    static_assert(radix_sort_digit<radix_bits>::buckets == radix_sort_shared_buckets,
+                  "control blocks are made for RADIX_SORT_DIGIT_BITS");
+
+    if (!count)
+        return;
+
+    radix_sort_shared_barrier barrier = { &control->barrier };
+
+    radix_sort_parallel_slice<radix_bits>(src, count, dst, bitwise_transform, reinterpret_cast<unsigned*>(control + 1),
+                                          control->process_count, rank, barrier);
+}
+
+// Any type radix_sort_transform takes.
+template <typename T>
+void radix_sort_shared(T* src, unsigned count, T* dst, radix_sort_shared_control* control, unsigned rank,
+                       radix_sort_order order = radix_sort_order::ascending)
+{
+    if (order == radix_sort_order::descending)
+        radix_sort_shared_impl<RADIX_SORT_DIGIT_BITS>(src, count, dst,
+            radix_sort_descending<radix_sort_transform>(radix_sort_transform()), control, rank);
+    else
+        radix_sort_shared_impl<RADIX_SORT_DIGIT_BITS>(src, count, dst, radix_sort_transform(), control, rank);
+}
+
+#endif //RADIX_SORT_SHARED_H
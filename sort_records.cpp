@@ -0,0 +1,524 @@
+#include "radix_sort.hpp"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+    Sorts a binary file of fixed size records by a key inside every record.
+
+    Both files are memory mapped. The keys are read straight from the
+    input mapping into an array of keys and record numbers, which is
+    radix sorted (only that array moves during the sort), then the records
+    are gathered from the input mapping into the output mapping in sorted
+    order. The sort is stable. Keys are in the byte order of the machine.
+
+    Usage: sort_records INPUT OUTPUT --record-size N [options]
+      --record-size N     bytes per record
+      --key-offset N      offset of the key in a record, 0 by default
+      --key-type T        uint8_t, int8_t, uint16_t, int16_t, uint32_t,
+                          int32_t, uint64_t, int64_t, float, double,
+                          uint128_t or int128_t; uint64_t by default
+      --descending        sort in descending order
+
+    Prints the time of every phase and the throughput (input bytes per
+    second) to stdout. The output space is allocated before the sort, and
+    the output is synced before the tool reports success, so a full disk
+    is an error message rather than a SIGBUS.
+
+    sort_records --check sorts generated files of records in $TMPDIR (or
+    /tmp) in both orders and checks the order, the stability and the
+    records of the results.
+*/
+
+using namespace std;
+
+struct sort_options
+{
+    size_t record_size = 0;
+    size_t key_offset = 0;
+    string key_type = "uint64_t";
+    radix_sort_order order = radix_sort_order::ascending;
+};
+
+// A read-only or a writable shared mapping of a whole file.
+class mapped_file
+{
+private:
+
+    int descriptor = -1;
+    char* address = nullptr;
+    size_t length = 0;
+
+public:
+
+    mapped_file() = default;
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file()
+    {
+        if (address)
+            munmap(address, length);
+
+        if (descriptor >= 0)
+            close(descriptor);
+    }
+
+    bool open_input(const char* path)
+    {
+        descriptor = open(path, O_RDONLY);
+
+        struct stat status;
+
+        if (descriptor < 0 || fstat(descriptor, &status) != 0)
+            return false;
+
+        return map(size_t(status.st_size), PROT_READ);
+    }
+
+    // The blocks of the output are allocated here: writes to a hole of a
+    // shared mapping that the disk has no room for raise SIGBUS.
+    bool open_output(const char* path, const size_t size)
+    {
+        descriptor = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if (descriptor < 0 || ftruncate(descriptor, off_t(size)) != 0)
+            return false;
+
+        if (size)
+        {
+            // posix_fallocate returns the error instead of setting errno.
+            const int error = posix_fallocate(descriptor, 0, off_t(size));
+
+            if (error)
+            {
+                errno = error;
+                return false;
+            }
+        }
+
+        return map(size, PROT_READ | PROT_WRITE);
+    }
+
+    // Writes the mapping out and unmaps it; false (with errno) if it
+    // couldn't be written.
+    bool sync()
+    {
+        if (!address)
+            return true;
+
+        const bool synced = msync(address, length, MS_SYNC) == 0;
+        const int error = errno;
+        const bool unmapped = munmap(address, length) == 0;
+
+        address = nullptr;
+
+        if (!synced)
+            errno = error;
+
+        return synced && unmapped;
+    }
+
+    // Same file as other, which would be overwritten while it's read.
+    bool same_file(const char* path) const
+    {
+        struct stat mapped, other;
+
+        return fstat(descriptor, &mapped) == 0 && stat(path, &other) == 0 &&
+               mapped.st_dev == other.st_dev && mapped.st_ino == other.st_ino;
+    }
+
+    void advise(int advice) const
+    {
+        if (address)
+            madvise(address, length, advice);
+    }
+
+    char* data() const { return address; }
+    size_t size() const { return length; }
+
+private:
+
+    bool map(const size_t size, const int protection)
+    {
+        length = size;
+
+        // mmap doesn't take empty mappings
+        if (!length)
+            return true;
+
+        void* mapping = mmap(nullptr, length, protection, MAP_SHARED, descriptor, 0);
+
+        if (mapping == MAP_FAILED)
+            return false;
+
+        address = static_cast<char*>(mapping);
+        return true;
+    }
+};
+
+double seconds_since(const chrono::steady_clock::time_point& start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void report(const char* phase, const double seconds, const size_t bytes)
+{
+    cout << phase << ": " << seconds << " sec, " << (seconds > 0 ? bytes / seconds / 1e9 : 0) << " GB/s" << endl;
+}
+
+// Keys are sorted together with the number of their record, which moves
+// less memory than a separate payload column.
+template <typename K>
+struct sort_entry
+{
+    K key;
+    unsigned record;
+};
+
+template <typename K>
+int sort_records(const mapped_file& input, const char* output_path, const sort_options& options)
+{
+    const size_t count = input.size() / options.record_size;
+    const size_t record_size = options.record_size;
+
+    mapped_file output;
+
+    if (!output.open_output(output_path, input.size()))
+    {
+        cerr << "Can't create " << output_path << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    // The keys with their record numbers, then the buffer of the sort.
+    radix_sort_workspace columns;
+    radix_sort_workspace workspace;
+
+    sort_entry<K>* entries = columns.buffer<sort_entry<K> >(count);
+
+    const auto start = chrono::steady_clock::now();
+
+    input.advise(MADV_SEQUENTIAL);
+    input.advise(MADV_WILLNEED);
+
+    const char* key = input.data() + options.key_offset;
+
+    for (size_t i = 0; i < count; ++i, key += record_size)
+    {
+        memcpy(&entries[i].key, key, sizeof(K));
+        entries[i].record = unsigned(i);
+    }
+
+    const double read_time = seconds_since(start);
+
+    const auto sort_start = chrono::steady_clock::now();
+
+    radix_sort_by_key(entries, unsigned(count), [](const sort_entry<K>& entry) { return entry.key; },
+                      workspace, options.order);
+
+    const double sort_time = seconds_since(sort_start);
+
+    const auto gather_start = chrono::steady_clock::now();
+
+    // Records are read in sorted order, so there is no point in read-ahead;
+    // the next ones are prefetched instead.
+    input.advise(MADV_RANDOM);
+    output.advise(MADV_SEQUENTIAL);
+
+    const unsigned prefetch_distance = 16;
+
+    const char* from = input.data();
+    char* to = output.data();
+
+    for (size_t i = 0; i < count; ++i, to += record_size)
+    {
+        if (i + prefetch_distance < count)
+            __builtin_prefetch(from + size_t(entries[i + prefetch_distance].record) * record_size);
+
+        memcpy(to, from + size_t(entries[i].record) * record_size, record_size);
+    }
+
+    if (!output.sync())
+    {
+        cerr << "Can't write " << output_path << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    const double gather_time = seconds_since(gather_start);
+    const double total_time = seconds_since(start);
+
+    cout << "Sorted " << count << " records of " << record_size << " bytes by "
+         << options.key_type << " at offset " << options.key_offset << endl;
+
+    report("Reading keys", read_time, input.size());
+    report("Sorting keys", sort_time, input.size());
+    report("Writing records", gather_time, input.size());
+    report("Total", total_time, input.size());
+
+    return 0;
+}
+
+int dispatch(const mapped_file& input, const char* output_path, const sort_options& options)
+{
+    const string& type = options.key_type;
+
+    if (type == "uint8_t")
+        return sort_records<uint8_t>(input, output_path, options);
+    if (type == "int8_t")
+        return sort_records<int8_t>(input, output_path, options);
+    if (type == "uint16_t")
+        return sort_records<uint16_t>(input, output_path, options);
+    if (type == "int16_t")
+        return sort_records<int16_t>(input, output_path, options);
+    if (type == "uint32_t")
+        return sort_records<uint32_t>(input, output_path, options);
+    if (type == "int32_t")
+        return sort_records<int32_t>(input, output_path, options);
+    if (type == "uint64_t")
+        return sort_records<uint64_t>(input, output_path, options);
+    if (type == "int64_t")
+        return sort_records<int64_t>(input, output_path, options);
+    if (type == "float")
+        return sort_records<float>(input, output_path, options);
+    if (type == "double")
+        return sort_records<double>(input, output_path, options);
+#ifdef __SIZEOF_INT128__
+    if (type == "uint128_t")
+        return sort_records<unsigned __int128>(input, output_path, options);
+    if (type == "int128_t")
+        return sort_records<__int128>(input, output_path, options);
+#endif
+
+    cerr << "Unknown key type: " << type << endl;
+    return 1;
+}
+
+size_t key_size(const string& type)
+{
+    if (type == "uint8_t" || type == "int8_t")
+        return 1;
+    if (type == "uint16_t" || type == "int16_t")
+        return 2;
+    if (type == "uint32_t" || type == "int32_t" || type == "float")
+        return 4;
+    if (type == "uint128_t" || type == "int128_t")
+        return 16;
+
+    return 8;
+}
+
+// --check: records of 32 bytes with the key at offset 4 and the record
+// number at offset 24, random bytes elsewhere. Keys take 200 values, so
+// that many are equal and show whether the sort is stable.
+template <typename K>
+bool check_key_type(const char* type, const string& dir)
+{
+    const size_t record_size = 32;
+    const size_t key_offset = 4;
+    const size_t number_offset = 24;
+    const size_t count = 100000;
+
+    const string suffix = "." + to_string(getpid());
+    const string input_path = dir + "/sort_records_check_input" + suffix;
+    const string output_path = dir + "/sort_records_check_output" + suffix;
+
+    vector<char> records(count * record_size);
+    mt19937_64 generator(42);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        char* record = &records[i * record_size];
+
+        for (size_t byte = 0; byte < record_size; ++byte)
+            record[byte] = char(generator());
+
+        const K key = K(int(generator() % 200) - 100);
+        const uint64_t number = i;
+
+        memcpy(record + key_offset, &key, sizeof(K));
+        memcpy(record + number_offset, &number, sizeof(number));
+    }
+
+    FILE* file = fopen(input_path.c_str(), "wb");
+
+    bool ok = file && fwrite(records.data(), 1, records.size(), file) == records.size();
+    ok = file && fclose(file) == 0 && ok;
+
+    for (const auto order : { radix_sort_order::ascending, radix_sort_order::descending })
+    {
+        sort_options options;
+        options.record_size = record_size;
+        options.key_offset = key_offset;
+        options.key_type = type;
+        options.order = order;
+
+        mapped_file input;
+
+        ok = ok && input.open_input(input_path.c_str()) && sort_records<K>(input, output_path.c_str(), options) == 0;
+
+        vector<char> sorted(records.size() + 1);
+
+        file = ok ? fopen(output_path.c_str(), "rb") : nullptr;
+        ok = file && fread(sorted.data(), 1, sorted.size(), file) == records.size();
+
+        if (file)
+            fclose(file);
+
+        vector<bool> seen(count, false);
+
+        for (size_t i = 0; ok && i < count; ++i)
+        {
+            const char* record = &sorted[i * record_size];
+
+            uint64_t number;
+            memcpy(&number, record + number_offset, sizeof(number));
+
+            // Every record once, as it was in the input.
+            if (number >= count || seen[number] || memcmp(record, &records[number * record_size], record_size))
+            {
+                ok = false;
+                break;
+            }
+
+            seen[number] = true;
+
+            if (!i)
+                continue;
+
+            K key, previous_key;
+            uint64_t previous_number;
+
+            memcpy(&key, record + key_offset, sizeof(K));
+            memcpy(&previous_key, record - record_size + key_offset, sizeof(K));
+            memcpy(&previous_number, record - record_size + number_offset, sizeof(previous_number));
+
+            auto previous = radix_sort_transform()(previous_key);
+            auto current = radix_sort_transform()(key);
+
+            if (order == radix_sort_order::descending)
+                swap(previous, current);
+
+            ok = previous < current || (previous == current && previous_number < number);
+        }
+    }
+
+    remove(input_path.c_str());
+    remove(output_path.c_str());
+
+    if (!ok)
+        cerr << "sort_records of " << type << " keys: result is wrong" << endl;
+
+    return ok;
+}
+
+int check_records()
+{
+    const char* dir = getenv("TMPDIR");
+    const string check_dir = dir && *dir ? dir : "/tmp";
+
+    const bool ok = check_key_type<uint8_t>("uint8_t", check_dir) &&
+                    check_key_type<int16_t>("int16_t", check_dir) &&
+                    check_key_type<uint32_t>("uint32_t", check_dir) &&
+                    check_key_type<int64_t>("int64_t", check_dir) &&
+                    check_key_type<float>("float", check_dir) &&
+#ifdef __SIZEOF_INT128__
+                    check_key_type<__int128>("int128_t", check_dir) &&
+#endif
+                    check_key_type<double>("double", check_dir);
+
+    if (ok)
+        cerr << "All checks passed" << endl;
+
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    sort_options options;
+
+    if (argc == 2 && string(argv[1]) == "--check")
+        return check_records();
+
+    const char* paths[2] = { nullptr, nullptr };
+    unsigned path_count = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const string arg = argv[i];
+
+        if (arg == "--descending")
+            options.order = radix_sort_order::descending;
+        else if (arg.compare(0, 2, "--") != 0 && path_count < 2)
+            paths[path_count++] = argv[i];
+        else if (i + 1 == argc)
+        {
+            cerr << "Unknown option or missing value: " << arg << endl;
+            return 1;
+        }
+        else if (arg == "--record-size")
+            options.record_size = size_t(strtoull(argv[++i], nullptr, 10));
+        else if (arg == "--key-offset")
+            options.key_offset = size_t(strtoull(argv[++i], nullptr, 10));
+        else if (arg == "--key-type")
+            options.key_type = argv[++i];
+        else
+        {
+            cerr << "Unknown option: " << arg << endl;
+            return 1;
+        }
+    }
+
+    if (path_count != 2 || !options.record_size)
+    {
+        cerr << "Usage: sort_records INPUT OUTPUT --record-size N [--key-offset N] "
+                "[--key-type T] [--descending]" << endl;
+        return 1;
+    }
+
+    if (options.key_offset + key_size(options.key_type) > options.record_size)
+    {
+        cerr << "The key doesn't fit into a record" << endl;
+        return 1;
+    }
+
+    mapped_file input;
+
+    if (!input.open_input(paths[0]))
+    {
+        cerr << "Can't read " << paths[0] << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    if (input.same_file(paths[1]))
+    {
+        cerr << "The output can't be the input file" << endl;
+        return 1;
+    }
+
+    if (input.size() % options.record_size)
+    {
+        cerr << "The file size isn't a multiple of the record size" << endl;
+        return 1;
+    }
+
+    if (input.size() / options.record_size > UINT_MAX)
+    {
+        cerr << "More than " << UINT_MAX << " records" << endl;
+        return 1;
+    }
+
+    return dispatch(input, paths[1], options);
+}